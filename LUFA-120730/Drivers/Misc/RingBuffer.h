@@ -57,6 +57,14 @@
  *  or deletions) must not overlap. If there is possibility of two or more of the same kind of
  *  operating occurring at the same point in time, atomic (mutex) locking should be used.
  *
+ *  By default the stored byte count is shared between the inserting and removing threads, so each insertion
+ *  and removal briefly disables global interrupts to update it. If the \c RING_BUFFER_LOCK_FREE compile time
+ *  token is defined, each buffer instead keeps separate 8-bit insertion and removal indexes which are only
+ *  written by their own thread, so no interrupt masking is needed at all and interrupt latency is unaffected
+ *  by buffer accesses. In this mode the size of each buffer must be a power of two no larger than 128 bytes;
+ *  a constant size which breaks this rule stops the build, and other sizes are checked by an assertion unless
+ *  \c NDEBUG is defined.
+ *
  *  \section Sec_ExampleUsage Example Usage
  *  The following snippet is an example of how this module may be used within a typical
  *  application.
@@ -96,6 +104,10 @@
 	/* Includes: */
 		#include "../../Common/Common.h"
 
+		#if defined(RING_BUFFER_LOCK_FREE)
+			#include <assert.h>
+		#endif
+
 	/* Enable C linkage for C++ Compilers: */
 		#if defined(__cplusplus)
 			extern "C" {
@@ -107,6 +119,7 @@
 		 *  Type define for a new ring buffer object. Buffers should be initialized via a call to
 		 *  \ref RingBuffer_InitBuffer() before use.
 		 */
+		#if !defined(RING_BUFFER_LOCK_FREE)
 		typedef struct
 		{
 			uint8_t* In; /**< Current storage location in the circular buffer. */
@@ -116,6 +129,26 @@
 			uint16_t Size; /**< Size of the buffer's underlying storage array. */
 			uint16_t Count; /**< Number of bytes currently stored in the buffer. */
 		} RingBuffer_t;
+		#else
+		typedef struct
+		{
+			uint8_t* Start; /**< Pointer to the start of the buffer's underlying storage array. */
+			volatile uint8_t In; /**< Free running storage index, only written by the inserting thread. */
+			volatile uint8_t Out; /**< Free running retrieval index, only written by the removing thread. */
+			uint8_t  Mask; /**< Mask applied to the indexes to give a location in the storage array. */
+			uint16_t Size; /**< Size of the buffer's underlying storage array. */
+		} RingBuffer_t;
+		#endif
+
+	/* Private Interface - For use in library only: */
+	#if !defined(__DOXYGEN__) && defined(RING_BUFFER_LOCK_FREE)
+		/* Macros: */
+			#define RING_BUFFER_INVALID_SIZE(Size)   (((Size) == 0) || ((Size) & ((Size) - 1)) || ((Size) > 128))
+
+		/* Function Prototypes: */
+			/* Never defined; a call to this left after optimization breaks the build with the message below */
+			void RingBuffer_InvalidSize(void) __attribute__ ((error("Ring buffer size must be a power of two no larger than 128 when RING_BUFFER_LOCK_FREE is defined")));
+	#endif
 
 	/* Inline Functions: */
 		/** Initializes a ring buffer ready for use. Buffers must be initialized via this function
@@ -124,7 +157,8 @@
 		 *
 		 *  \param[out] Buffer   Pointer to a ring buffer structure to initialize.
 		 *  \param[out] DataPtr  Pointer to a global array that will hold the data stored into the ring buffer.
-		 *  \param[out] Size     Maximum number of bytes that can be stored in the underlying data array.
+		 *  \param[out] Size     Maximum number of bytes that can be stored in the underlying data array. When the
+		 *                       \c RING_BUFFER_LOCK_FREE token is defined, this must be a power of two no larger than 128.
 		 */
 		static inline void RingBuffer_InitBuffer(RingBuffer_t* Buffer, uint8_t* const DataPtr, const uint16_t Size)
 		                                         ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(2);
@@ -135,12 +169,26 @@
 			uint_reg_t CurrentGlobalInt = GetGlobalInterruptMask();
 			GlobalInterruptDisable();
 
+			#if !defined(RING_BUFFER_LOCK_FREE)
 			Buffer->In     = DataPtr;
 			Buffer->Out    = DataPtr;
 			Buffer->Start  = &DataPtr[0];
 			Buffer->End    = &DataPtr[Size];
 			Buffer->Size   = Size;
 			Buffer->Count  = 0;
+			#else
+			/* The index masking needs a power of two size; checked at compile time for constant sizes, and by an assertion otherwise */
+			if (GCC_IS_COMPILE_CONST(Size) && RING_BUFFER_INVALID_SIZE(Size))
+			  RingBuffer_InvalidSize();
+
+			assert(!RING_BUFFER_INVALID_SIZE(Size));
+
+			Buffer->In     = 0;
+			Buffer->Out    = 0;
+			Buffer->Start  = &DataPtr[0];
+			Buffer->Mask   = (Size - 1);
+			Buffer->Size   = Size;
+			#endif
 
 			SetGlobalInterruptMask(CurrentGlobalInt);
 		}
@@ -162,6 +210,10 @@
 		static inline uint16_t RingBuffer_GetCount(RingBuffer_t* const Buffer) ATTR_WARN_UNUSED_RESULT ATTR_NON_NULL_PTR_ARG(1);
 		static inline uint16_t RingBuffer_GetCount(RingBuffer_t* const Buffer)
 		{
+			#if defined(RING_BUFFER_LOCK_FREE)
+			/* Each index is a single byte, so both are read atomically without a lock */
+			return (uint8_t)(Buffer->In - Buffer->Out);
+			#else
 			uint16_t Count;
 
 			uint_reg_t CurrentGlobalInt = GetGlobalInterruptMask();
@@ -171,6 +223,7 @@
 
 			SetGlobalInterruptMask(CurrentGlobalInt);
 			return Count;
+			#endif
 		}
 
 		/** Retrieves the free space in a particular buffer. This value is computed by entering an atomic lock
@@ -237,6 +290,16 @@
 		{
 			GCC_FORCE_POINTER_ACCESS(Buffer);
 
+			#if defined(RING_BUFFER_LOCK_FREE)
+			uint8_t In = Buffer->In;
+
+			Buffer->Start[In & Buffer->Mask] = Data;
+
+			/* The data must be stored before the removing thread can see the new index */
+			GCC_MEMORY_BARRIER();
+			Buffer->In = (In + 1);
+			#else
+
 			*Buffer->In = Data;
 
 			if (++Buffer->In == Buffer->End)
@@ -248,6 +311,7 @@
 			Buffer->Count++;
 
 			SetGlobalInterruptMask(CurrentGlobalInt);
+			#endif
 		}
 
 		/** Removes an element from the ring buffer.
@@ -265,6 +329,17 @@
 		{
 			GCC_FORCE_POINTER_ACCESS(Buffer);
 
+			#if defined(RING_BUFFER_LOCK_FREE)
+			uint8_t Out  = Buffer->Out;
+			uint8_t Data = Buffer->Start[Out & Buffer->Mask];
+
+			/* The data must be read before the inserting thread can see the freed location */
+			GCC_MEMORY_BARRIER();
+			Buffer->Out = (Out + 1);
+
+			return Data;
+			#else
+
 			uint8_t Data = *Buffer->Out;
 
 			if (++Buffer->Out == Buffer->End)
@@ -278,6 +353,7 @@
 			SetGlobalInterruptMask(CurrentGlobalInt);
 
 			return Data;
+			#endif
 		}
 
 		/** Returns the next element stored in the ring buffer, without removing it.
@@ -289,7 +365,11 @@
 		static inline uint8_t RingBuffer_Peek(RingBuffer_t* const Buffer) ATTR_WARN_UNUSED_RESULT ATTR_NON_NULL_PTR_ARG(1);
 		static inline uint8_t RingBuffer_Peek(RingBuffer_t* const Buffer)
 		{
+			#if defined(RING_BUFFER_LOCK_FREE)
+			return Buffer->Start[Buffer->Out & Buffer->Mask];
+			#else
 			return *Buffer->Out;
+			#endif
 		}
 
 	/* Disable C linkage for C++ Compilers: */
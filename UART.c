@@ -27,149 +27,564 @@
 #include <stdio.h>
 #include <string.h>
 #include <avr/io.h>
+#include <avr/pgmspace.h>
 #include "UART.h"
 
-FILE UART_stdout = FDEV_SETUP_STREAM(UARTPutChar, NULL, _FDEV_SETUP_WRITE);
+static void UARTPortInit(const UARTPort *port, uint16_t BaudSetting);
+static void UARTSetBaudSetting(const UARTPort *port, uint16_t BaudSetting);
+static uint16_t UARTWriteBlock(const UARTPort *port, const uint8_t *buf, uint16_t len, uint8_t InProgmem);
+
+#if UART_USE_BUFFERS == 1
+static inline void UARTTxStart(const UARTPort *port);
+static inline void UARTTxSendNext(const UARTPort *port);
+static inline void UARTTxWait(const UARTPort *port);
+static inline void UARTRxStore(const UARTPort *port);
+
+#if UART_USE_FLOW_CONTROL == 1
+static inline void UARTTxComplete(const UARTPort *port);
+
+#define UART_DEFINE_TXC_ISR(n)																			\
+	ISR(UART##n##_TX_vect)																				\
+	{																									\
+		UARTTxComplete(&UARTPort##n);																	\
+	}
+#else
+#define UART_DEFINE_TXC_ISR(n)
+#endif
+
+//The stream of a port, like FDEV_SETUP_STREAM() but with the port as udata so it works without any setup at runtime
+#define UART_STREAM_INIT(n)		{ .put = UARTPutChar, .get = UARTGetChar, .flags = _FDEV_SETUP_RW, .udata = (void *)&UARTPort##n }
+
+//Creates the buffers, the port and the ISRs of a USART. The ISRs use a constant port, so all register and buffer addresses are resolved at compile time.
+#define UART_DEFINE_PORT(n)																				\
+	static volatile uint8_t UART##n##_TxBuffer[UART##n##_TX_BUFFER_SIZE];								\
+	static volatile uint8_t UART##n##_RxBuffer[UART##n##_RX_BUFFER_SIZE];								\
+	UARTPortState UARTState##n = { .Stream = UART_STREAM_INIT(n) };										\
+	const UARTPort UARTPort##n = { UART##n##_REGS, UART##n##_TxBuffer, UART##n##_RxBuffer,				\
+								   UART##n##_TX_BUFFER_SIZE - 1, UART##n##_RX_BUFFER_SIZE - 1, &UARTState##n };	\
+	ISR(UART##n##_UDRE_vect)																			\
+	{																									\
+		UARTTxSendNext(&UARTPort##n);																	\
+	}																									\
+	ISR(UART##n##_RX_vect)																				\
+	{																									\
+		UARTRxStore(&UARTPort##n);																		\
+	}																									\
+	UART_DEFINE_TXC_ISR(n)
+#else
+#define UART_STREAM_INIT(n)		{ .put = UARTPutChar, .get = NULL, .flags = _FDEV_SETUP_WRITE, .udata = (void *)&UARTPort##n }
+
+#define UART_DEFINE_PORT(n)																				\
+	UARTPortState UARTState##n = { .Stream = UART_STREAM_INIT(n) };										\
+	const UARTPort UARTPort##n = { UART##n##_REGS, &UARTState##n };
+#endif
+
+#if UART0_ENABLE == 1
+UART_DEFINE_PORT(0)
+#endif
+#if UART1_ENABLE == 1
+UART_DEFINE_PORT(1)
+#endif
+#if UART2_ENABLE == 1
+UART_DEFINE_PORT(2)
+#endif
+#if UART3_ENABLE == 1
+UART_DEFINE_PORT(3)
+#endif
 
 void UARTinit (void)
 {
-	#if defined (__AVR_ATmega328P__) || defined (__AVR_ATmega328__)
-		PRR &= ~(1<<PRUSART0);			//Turn on UART power
-		DDRD |= (1<<1);					//PD1 as output (TxD)
-		DDRB &= ~(1<<0);				//PD0 as input (RxD)
-		
-		//Set USART Baud Rate
-		UBRR0H = MYUBRR >> 8;
-		UBRR0L = MYUBRR;
-		UCSR0B = (1<<RXEN0)|(1<<TXEN0);		//Activate RX, TX
-
-	#elif defined (__AVR_ATmega32U4__)
-		PRR0 &= ~(1<<PRUSART0);			//Turn on UART power
-		DDRD |= (1<<3);					//PD3 as output (TxD)
-		DDRB &= ~(1<<2);				//PD2 as input (RxD)
-		
-		//Set USART Baud Rate
-		UBRR1H = MYUBRR >> 8;
-		UBRR1L = MYUBRR;
-		UCSR1B = (1<<RXEN1)|(1<<TXEN1);		//Activate RX, TX
-	#elif defined (__AVR_ATmega2561__)
-		#if UART_NUMBER == 0
-			PRR0 &= ~(1<<PRUSART0);			//Turn on UART power
-			DDRE |= (1<<1);					//PE1 as output (TxD)
-			DDRE &= ~(1<<0);				//PE0 as input (RxD)
-		
-			//Set USART Baud Rate
-			UBRR0H = MYUBRR >> 8;
-			UBRR0L = MYUBRR;
-			UCSR0B = (1<<RXEN0)|(1<<TXEN0);		//Activate RX, TX
-		#elif UART_NUMBER == 1
-			PRR1 &= ~(1<<PRUSART1);			//Turn on UART power
-			DDRD |= (1<<3);					//PD3 as output (TxD)
-			DDRD &= ~(1<<2);				//PD2 as input (RxD)
-			
-			//Set USART Baud Rate
-			UBRR1H = MYUBRR >> 8;
-			UBRR1L = MYUBRR;
-			UCSR1B = (1<<RXEN1)|(1<<TXEN1);		//Activate RX, TX
-			UCSR1C = (3<<UCSZ10);				//Set frame format: 8data, 1stop bit TODO: Do I need this for the other cases?
-		#elif UART_NUMBER == 2
-			PRR1 &= ~(1<<PRUSART2);			//Turn on UART power
-			DDRH |= (1<<1);					//PH1 as output (TxD)
-			DDRH &= ~(1<<0);				//PH0 as input (RxD)
-			
-			//Set USART Baud Rate
-			UBRR2H = MYUBRR >> 8;
-			UBRR2L = MYUBRR;
-			UCSR2B = (1<<RXEN2)|(1<<TXEN2);		//Activate RX, TX
-		#elif UART_NUMBER == 3
-			PRR1 &= ~(1<<PRUSART3);			//Turn on UART power
-			DDRJ |= (1<<1);					//PJ1 as output (TxD)
-			DDRJ &= ~(1<<0);				//PJ0 as input (RxD)
-			
-			//Set USART Baud Rate
-			UBRR3H = MYUBRR >> 8;
-			UBRR3L = MYUBRR;
-			UCSR3B = (1<<RXEN3)|(1<<TXEN3);		//Activate RX, TX			
-		#else
-			#error: UART number not defined
-		#endif
-	#else
-		#error: MCU not defined/handled
+	//Note: the TxD and RxD pin directions are overridden by the USART when TX and RX are enabled, so DDRx is not set here.
+	#if UART0_ENABLE == 1
+		UART0_PRR &= ~(1<<UART0_PRR_BIT);		//Turn on UART power
+		UARTPortInit(&UARTPort0, UART_BAUD_SETTING(UART0_BAUD));
+	#endif
+	#if UART1_ENABLE == 1
+		UART1_PRR &= ~(1<<UART1_PRR_BIT);		//Turn on UART power
+		UARTPortInit(&UARTPort1, UART_BAUD_SETTING(UART1_BAUD));
+	#endif
+	#if UART2_ENABLE == 1
+		UART2_PRR &= ~(1<<UART2_PRR_BIT);		//Turn on UART power
+		UARTPortInit(&UARTPort2, UART_BAUD_SETTING(UART2_BAUD));
+	#endif
+	#if UART3_ENABLE == 1
+		UART3_PRR &= ~(1<<UART3_PRR_BIT);		//Turn on UART power
+		UARTPortInit(&UARTPort3, UART_BAUD_SETTING(UART3_BAUD));
 	#endif
 	
 	#ifdef UART_ENABLE_LOOPBACK
 	UARTRXINTON();	//TODO:Check if this works
 	#endif
     
-    //stdout = &mystdout; 	//Required for printf init
+    //stdout = &UART_stdout; 	//Required for printf init
+}
+
+static void UARTPortInit(const UARTPort *port, uint16_t BaudSetting)
+{
+	UARTSetBaudSetting(port, BaudSetting);
+	UART_REG(port, UART_UCSRC) = (3<<UART_BIT_UCSZ0);			//Set frame format: 8data, 1stop bit
+
+#if UART_USE_BUFFERS == 1
+	port->State->TxHead = 0;
+	port->State->TxTail = 0;
+	port->State->RxHead = 0;
+	port->State->RxTail = 0;
+	port->State->RxOverflowCount = 0;
+#if UART_USE_RX_HANDLER == 1
+	port->State->RxHandler = NULL;
+#endif
+#if UART_USE_FLOW_CONTROL == 1
+	port->State->RtsMask = 0;
+	port->State->CtsMask = 0;
+	port->State->DeMask = 0;
+#endif
+
+	//Activate RX, TX and the RX interrupt. The UDRE interrupt is turned on when there is data to send.
+	UART_REG(port, UART_UCSRB) = (1<<UART_BIT_RXEN)|(1<<UART_BIT_TXEN)|(1<<UART_BIT_RXCIE);
+#else
+	UART_REG(port, UART_UCSRB) = (1<<UART_BIT_RXEN)|(1<<UART_BIT_TXEN);		//Activate RX, TX
+#endif
+}
+
+//Set the UBRR and U2X bits. BaudSetting is the UBRR value with the U2X flag in bit 15 (see UART_BAUD_SETTING())
+static void UARTSetBaudSetting(const UARTPort *port, uint16_t BaudSetting)
+{
+	if(BaudSetting & 0x8000)
+	{
+		UART_REG(port, UART_UCSRA) = (1<<UART_BIT_U2X);
+	}
+	else
+	{
+		UART_REG(port, UART_UCSRA) = 0;
+	}
+
+	UART_REG(port, UART_UBRRH) = (BaudSetting >> 8) & 0x0F;
+	UART_REG(port, UART_UBRRL) = BaudSetting;
+}
+
+uint16_t UARTSetBaud(const UARTPort *port, uint32_t baud)
+{
+	uint32_t ubrr1x;
+	uint32_t ubrr2x;
+	uint16_t error1x = 0xFFFF;
+	uint16_t error2x = 0xFFFF;
+
+	if(baud == 0)
+	{
+		return 0xFFFF;
+	}
+
+	//Same math as the UART_BAUD_SETTING() macro
+	ubrr1x = UART_UBRR_1X(baud);
+	ubrr2x = UART_UBRR_2X(baud);
+	if((ubrr1x <= UART_UBRR_MAX) && (F_CPU >= 16UL*baud))
+	{
+		error1x = UART_ERROR(F_CPU / (16UL*(ubrr1x + 1)), baud);
+	}
+	if((ubrr2x <= UART_UBRR_MAX) && (F_CPU >= 8UL*baud))
+	{
+		error2x = UART_ERROR(F_CPU / (8UL*(ubrr2x + 1)), baud);
+	}
+
+	if((error1x == 0xFFFF) && (error2x == 0xFFFF))
+	{
+		return 0xFFFF;
+	}
+
+#if UART_USE_BUFFERS == 1
+	UARTFlush(port);
+#endif
+	loop_until_bit_is_set(UART_REG(port, UART_UCSRA), UART_BIT_UDRE);
+
+	if(error2x < error1x)
+	{
+		UARTSetBaudSetting(port, ubrr2x | 0x8000);
+		return error2x;
+	}
+	UARTSetBaudSetting(port, ubrr1x);
+	return error1x;
 }
 
 int UARTPutChar(char c, FILE *stream)
 {
+	const UARTPort *port = UART_DEFAULT_PORT;
+
+	if(stream != NULL)
+	{
+		port = (const UARTPort *)fdev_get_udata(stream);
+	}
+
     if (c == '\n') UARTPutChar('\r', stream);
   
-	#if defined (__AVR_ATmega328P__) || defined (__AVR_ATmega328__)
-		loop_until_bit_is_set(UCSR0A, UDRE0);
-		UDR0 = c;
-	#elif defined (__AVR_ATmega32U4__)
-		loop_until_bit_is_set(UCSR1A, UDRE1);
-		UDR1 = c;
-	#elif defined (__AVR_ATmega2561__)
-		#if UART_NUMBER == 0
-			loop_until_bit_is_set(UCSR0A, UDRE0);
-			UDR0 = c;
-		#elif UART_NUMBER == 1
-			loop_until_bit_is_set(UCSR1A, UDRE1);
-			UDR1 = c;
-		#elif UART_NUMBER == 2
-			loop_until_bit_is_set(UCSR2A, UDRE2);
-			UDR2 = c;
-		#elif UART_NUMBER == 3
-			loop_until_bit_is_set(UCSR3A, UDRE3);
-			UDR3 = c;
-		#else
-			#error: UART number not defined
-		#endif
-    #else
-		#error: MCU not defined/handled
+#if UART_USE_BUFFERS == 1
+	while(UARTPutByte(port, c) == 0)
+	{
+	#if UART_TX_BLOCK_WHEN_FULL == 1
+		UARTTxWait(port);
+	#else
+		return -1;
 	#endif
+	}
+#else
+	loop_until_bit_is_set(UART_REG(port, UART_UCSRA), UART_BIT_UDRE);
+	UART_REG(port, UART_UDR) = c;
+#endif
 	
     return 0;
 }
 
+uint16_t UARTWrite(const UARTPort *port, const uint8_t *buf, uint16_t len)
+{
+	return UARTWriteBlock(port, buf, len, 0);
+}
+
+uint16_t UARTWrite_P(const UARTPort *port, const uint8_t *buf, uint16_t len)
+{
+	return UARTWriteBlock(port, buf, len, 1);
+}
+
+static uint16_t UARTWriteBlock(const UARTPort *port, const uint8_t *buf, uint16_t len, uint8_t InProgmem)
+{
+	uint16_t written = 0;
+#if UART_USE_BUFFERS == 1
+	uint8_t head;
+	uint8_t space;
+	uint8_t i;
+
+	while(written < len)
+	{
+		head = port->State->TxHead;
+		space = (port->TxMask + 1) - (uint8_t)(head - port->State->TxTail);
+
+		if(space == 0)
+		{
+		#if UART_TX_BLOCK_WHEN_FULL == 1
+			UARTTxWait(port);
+			continue;
+		#else
+			break;
+		#endif
+		}
+
+		if(space > (len - written))
+		{
+			space = len - written;
+		}
+
+		//Copy as much as fits, then hand it all to the ISR with a single head update
+		if(InProgmem)
+		{
+			for(i = 0; i < space; i++)
+			{
+				port->TxBuffer[(uint8_t)(head + i) & port->TxMask] = pgm_read_byte(buf++);
+			}
+		}
+		else
+		{
+			for(i = 0; i < space; i++)
+			{
+				port->TxBuffer[(uint8_t)(head + i) & port->TxMask] = *buf++;
+			}
+		}
+		port->State->TxHead = head + space;
+		written += space;
+
+		UARTTxStart(port);
+	}
+#else
+	for(written = 0; written < len; written++)
+	{
+		loop_until_bit_is_set(UART_REG(port, UART_UCSRA), UART_BIT_UDRE);
+		if(InProgmem)
+		{
+			UART_REG(port, UART_UDR) = pgm_read_byte(buf++);
+		}
+		else
+		{
+			UART_REG(port, UART_UDR) = *buf++;
+		}
+	}
+#endif
+	return written;
+}
+
+#if UART_USE_BUFFERS == 1
+int UARTGetChar(FILE *stream)
+{
+	const UARTPort *port = UART_DEFAULT_PORT;
+	int16_t c;
+
+	if(stream != NULL)
+	{
+		port = (const UARTPort *)fdev_get_udata(stream);
+	}
+
+	while((c = UARTGetByte(port)) < 0) {}
+	return c;
+}
+
+uint8_t UARTPutByte(const UARTPort *port, uint8_t c)
+{
+	uint8_t head = port->State->TxHead;
+
+	if((uint8_t)(head - port->State->TxTail) > port->TxMask)
+	{
+		return 0;		//Buffer is full
+	}
+
+	port->TxBuffer[head & port->TxMask] = c;
+	port->State->TxHead = head + 1;
+
+	UARTTxStart(port);
+	return 1;
+}
+
+int16_t UARTGetByte(const UARTPort *port)
+{
+	uint8_t tail = port->State->RxTail;
+	uint8_t c;
+
+	if(tail == port->State->RxHead)
+	{
+		return -1;		//Buffer is empty
+	}
+
+	c = port->RxBuffer[tail & port->RxMask];
+	port->State->RxTail = ++tail;
+
+#if UART_USE_FLOW_CONTROL == 1
+	//Lower RTS again once the buffer is half empty
+	if((port->State->RtsMask != 0) && ((uint8_t)(port->State->RxHead - tail) <= (port->RxMask >> 1)))
+	{
+		uint8_t sreg = SREG;
+
+		cli();
+		*port->State->RtsPort &= ~port->State->RtsMask;
+		SREG = sreg;
+	}
+#endif
+	return c;
+}
+
+uint8_t UARTRxAvailable(const UARTPort *port)
+{
+	return (uint8_t)(port->State->RxHead - port->State->RxTail);
+}
+
+uint8_t UARTRxOverflows(const UARTPort *port)
+{
+	uint8_t count;
+	uint8_t sreg = SREG;
+
+	cli();
+	count = port->State->RxOverflowCount;
+	port->State->RxOverflowCount = 0;
+	SREG = sreg;
+
+	return count;
+}
+
+void UARTFlush(const UARTPort *port)
+{
+	while(port->State->TxHead != port->State->TxTail)
+	{
+		UARTTxWait(port);
+	}
+}
+
+#if UART_USE_RX_HANDLER == 1
+void UARTSetRxHandler(const UARTPort *port, void (*handler) (void *HandlerData, uint8_t c), void *HandlerData)
+{
+	uint8_t sreg = SREG;
+
+	cli();
+	port->State->RxHandlerData = HandlerData;
+	port->State->RxHandler = handler;
+	SREG = sreg;
+}
+#endif
+
+#if UART_USE_FLOW_CONTROL == 1
+void UARTSetFlowControl(const UARTPort *port, volatile uint8_t *RtsPort, uint8_t RtsPin, volatile uint8_t *CtsPort, uint8_t CtsPin)
+{
+	uint8_t sreg = SREG;
+
+	cli();
+	port->State->RtsMask = 0;
+	port->State->CtsMask = 0;
+
+	if(RtsPort != NULL)
+	{
+		*RtsPort &= ~(1<<RtsPin);				//RTS low, ready to receive
+		UART_DDR(RtsPort) |= (1<<RtsPin);		//RTS is an output
+		port->State->RtsPort = RtsPort;
+		port->State->RtsMask = (1<<RtsPin);
+	}
+
+	if(CtsPort != NULL)
+	{
+		UART_DDR(CtsPort) &= ~(1<<CtsPin);		//CTS is an input
+		port->State->CtsPort = CtsPort;
+		port->State->CtsMask = (1<<CtsPin);
+	}
+	SREG = sreg;
+}
+
+void UARTSetRS485(const UARTPort *port, volatile uint8_t *DePort, uint8_t DePin)
+{
+	uint8_t sreg = SREG;
+
+	UARTFlush(port);
+
+	cli();
+	if(port->State->DeMask != 0)
+	{
+		*port->State->DePort &= ~port->State->DeMask;			//Release the old DE pin
+	}
+	port->State->DeMask = 0;
+
+	if(DePort != NULL)
+	{
+		*DePort &= ~(1<<DePin);					//Driver off
+		UART_DDR(DePort) |= (1<<DePin);			//DE is an output
+		port->State->DePort = DePort;
+		port->State->DeMask = (1<<DePin);
+	}
+	SREG = sreg;
+}
+
+void UARTCheckCTS(const UARTPort *port)
+{
+	if(port->State->TxHead != port->State->TxTail)
+	{
+		UARTTxStart(port);
+	}
+}
+
+//The last byte has left the shift register, release the RS-485 driver if there is nothing else to send
+static inline void UARTTxComplete(const UARTPort *port)
+{
+	UART_REG(port, UART_UCSRB) &= ~(1<<UART_BIT_TXCIE);
+	if((port->State->TxHead == port->State->TxTail) && (port->State->DeMask != 0))
+	{
+		*port->State->DePort &= ~port->State->DeMask;
+	}
+}
+#endif
+
+//Turn on the UDRE interrupt to start sending
+static inline void UARTTxStart(const UARTPort *port)
+{
+#if UART_USE_FLOW_CONTROL == 1
+	//The ISRs also change TXCIE in UCSRB, so this must not be interrupted
+	uint8_t sreg = SREG;
+
+	cli();
+	UART_REG(port, UART_UCSRB) |= (1<<UART_BIT_UDRIE);
+	SREG = sreg;
+#else
+	//If the ISR clears UDRIE in the middle of this, it will just run once more and find the byte.
+	UART_REG(port, UART_UCSRB) |= (1<<UART_BIT_UDRIE);
+#endif
+}
+
+//Called while waiting for the TX buffer to empty, makes sure sending keeps going
+static inline void UARTTxWait(const UARTPort *port)
+{
+	if((SREG & (1<<SREG_I)) == 0)
+	{
+		//If interrupts are off the UDRE ISR cannot empty the buffer, so send a byte from here
+		loop_until_bit_is_set(UART_REG(port, UART_UCSRA), UART_BIT_UDRE);
+		UARTTxSendNext(port);
+	}
+#if UART_USE_FLOW_CONTROL == 1
+	else if((UART_REG(port, UART_UCSRB) & (1<<UART_BIT_UDRIE)) == 0)
+	{
+		UARTTxStart(port);		//Sending was stopped by CTS, try again
+	}
+#endif
+}
+
+//Move the next byte from the TX buffer to the USART, or stop the UDRE interrupt if the buffer is empty. UDRE must be set when this is called.
+static inline void UARTTxSendNext(const UARTPort *port)
+{
+	uint8_t tail = port->State->TxTail;
+
+	if(tail == port->State->TxHead)
+	{
+		UART_REG(port, UART_UCSRB) &= ~(1<<UART_BIT_UDRIE);
+	#if UART_USE_FLOW_CONTROL == 1
+		if(port->State->DeMask != 0)
+		{
+			UART_REG(port, UART_UCSRB) |= (1<<UART_BIT_TXCIE);	//Release DE when the last byte is out
+		}
+	#endif
+		return;
+	}
+
+#if UART_USE_FLOW_CONTROL == 1
+	if((port->State->CtsMask != 0) && (UART_PIN(port->State->CtsPort) & port->State->CtsMask))
+	{
+		UART_REG(port, UART_UCSRB) &= ~(1<<UART_BIT_UDRIE);		//Other side is not ready, UARTCheckCTS() starts this again
+		return;
+	}
+
+	if(port->State->DeMask != 0)
+	{
+		*port->State->DePort |= port->State->DeMask;
+		UART_REG(port, UART_UCSRA) = (UART_REG(port, UART_UCSRA) & (1<<UART_BIT_U2X)) | (1<<UART_BIT_TXC);	//Clear TXC so it only sets after this byte
+	}
+#endif
+
+	UART_REG(port, UART_UDR) = port->TxBuffer[tail & port->TxMask];
+	port->State->TxTail = tail + 1;
+}
+
+//Move a received byte from the USART to the RX buffer
+static inline void UARTRxStore(const UARTPort *port)
+{
+	uint8_t c = UART_REG(port, UART_UDR);
+	uint8_t head = port->State->RxHead;
+
+#if UART_USE_RX_HANDLER == 1
+	if(port->State->RxHandler != NULL)
+	{
+		port->State->RxHandler(port->State->RxHandlerData, c);
+		return;
+	}
+#endif
+
+	if((uint8_t)(head - port->State->RxTail) > port->RxMask)
+	{
+		if(port->State->RxOverflowCount < 0xFF)
+		{
+			port->State->RxOverflowCount++;
+		}
+		return;
+	}
+
+	port->RxBuffer[head & port->RxMask] = c;
+	port->State->RxHead = ++head;
+
+#if UART_USE_FLOW_CONTROL == 1
+	//Raise RTS when less than a quarter of the buffer is free, the sender may still have a few bytes on the way
+	if((port->State->RtsMask != 0) && ((uint8_t)(head - port->State->RxTail) > (port->RxMask - (port->RxMask >> 2))))
+	{
+		*port->State->RtsPort |= port->State->RtsMask;
+	}
+#endif
+}
+#endif
+
 #ifdef UART_ENABLE_LOOPBACK
 //Interrupt driven UART loopback
-//TODO: is the ISR vector the same for MCUs with multiple USARTS??
-ISR(USART_RX_vect)
+ISR(UART_DEFAULT_RX_vect)
 {
 	uint8_t c;
 
-	#if defined (__AVR_ATmega328P__) || defined (__AVR_ATmega328__)
-		c = UDR0;		//Get char from UART receive buffer
-		UDR0 = c;		//Send char out on UART transmit buffer
-	#elif defined (__AVR_ATmega32U4__)
-		c = UDR1;		//Get char from UART receive buffer
-		UDR1 = c;		//Send char out on UART transmit buffer
-    #elif defined (__AVR_ATmega2561__)
-    	#if UART_NUMBER == 0
-			c = UDR0;		//Get char from UART receive buffer
-			UDR0 = c;		//Send char out on UART transmit buffer
-    	#elif UART_NUMBER == 1
-			c = UDR1;		//Get char from UART receive buffer
-			UDR1 = c;		//Send char out on UART transmit buffer
-    	#elif UART_NUMBER == 2
-			c = UDR2;		//Get char from UART receive buffer
-			UDR2 = c;		//Send char out on UART transmit buffer
-    	#elif UART_NUMBER == 3
-			c = UDR3;		//Get char from UART receive buffer
-			UDR3 = c;		//Send char out on UART transmit buffer
-    	#else
-    		#error: UART number not defined
-    	#endif
-	#else
-		#error: MCU not defined/handled
-	#endif
+	c = UART_DEFAULT_REGS[UART_UDR];		//Get char from UART receive buffer
+	UART_DEFAULT_REGS[UART_UDR] = c;		//Send char out on UART transmit buffer
 }
 #endif
 
-/** @} */
\ No newline at end of file
+/** @} */
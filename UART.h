@@ -27,6 +27,7 @@
 #define _UART_H_
 
 #include "stdint.h"
+#include <stdio.h>
 #include "config.h"
 
 #ifndef UART_USER_CONFIG
@@ -37,42 +38,533 @@
 //#define UART_USER_CONFIG
 //#define UART_BAUD 9600
 //#undef UART_ENABLE_LOOPBACK
+//#define UART_USE_BUFFERS				1		//Set to 1 to use interrupt driven TX and RX ring buffers
+//#define UART_TX_BUFFER_SIZE			64		//Size of the TX ring buffer in bytes, must be a power of 2 and no more than 128
+//#define UART_RX_BUFFER_SIZE			32		//Size of the RX ring buffer in bytes, must be a power of 2 and no more than 128
+//#define UART_TX_BLOCK_WHEN_FULL		1		//Set to 1 to wait for space when the TX buffer is full, 0 to drop the character
+//#define UART_USE_FLOW_CONTROL		0		//Set to 1 to build RTS/CTS and RS-485 driver enable support (needs UART_USE_BUFFERS)
+//#define UART_USE_RX_HANDLER			0		//Set to 1 to build UARTSetRxHandler() (needs UART_USE_BUFFERS). The RX ISRs get slower because of the function pointer call.
+//#define UART_BAUD_ERROR_MAX			20		//Largest allowed baud rate error in 0.1% steps (20 = 2.0%)
+//#define UART_BAUD_ERROR_FATAL			0		//Set to 1 to stop the build if the baud rate error is too large, 0 to only warn
+//
+//More than one USART can be used at the same time. Enable each one that is needed.
+//If none are enabled, only the USART picked by UART_NUMBER (or the only USART on the part) is used, with the settings above.
+//#define UART0_ENABLE					1
+//#define UART0_BAUD					9600	//Defaults to UART_BAUD
+//#define UART0_TX_BUFFER_SIZE			64		//Defaults to UART_TX_BUFFER_SIZE
+//#define UART0_RX_BUFFER_SIZE			32		//Defaults to UART_RX_BUFFER_SIZE
+//(UART1_*, UART2_* and UART3_* are set the same way)
+//#define UART_DEFAULT_NUMBER			0		//The USART used for UART_stdout. Defaults to the lowest enabled USART.
+
+#ifndef UART_USE_BUFFERS
+	#define UART_USE_BUFFERS			0
+#endif
+
+#if UART_USE_BUFFERS == 1
+	#ifndef UART_TX_BUFFER_SIZE
+		#define UART_TX_BUFFER_SIZE		64
+	#endif
+	#ifndef UART_RX_BUFFER_SIZE
+		#define UART_RX_BUFFER_SIZE		32
+	#endif
+	#ifndef UART_TX_BLOCK_WHEN_FULL
+		#define UART_TX_BLOCK_WHEN_FULL	1
+	#endif
+	#ifdef UART_ENABLE_LOOPBACK
+		#error: UART_ENABLE_LOOPBACK cannot be used with UART_USE_BUFFERS
+	#endif
+#endif
+
+#ifndef UART_USE_FLOW_CONTROL
+	#define UART_USE_FLOW_CONTROL		0
+#endif
+
+#if (UART_USE_FLOW_CONTROL == 1) && (UART_USE_BUFFERS != 1)
+	#error: UART_USE_FLOW_CONTROL needs UART_USE_BUFFERS set to 1
+#endif
+
+#ifndef UART_USE_RX_HANDLER
+	#define UART_USE_RX_HANDLER			0
+#endif
+
+#if (UART_USE_RX_HANDLER == 1) && (UART_USE_BUFFERS != 1)
+	#error: UART_USE_RX_HANDLER needs UART_USE_BUFFERS set to 1
+#endif
+
+#ifndef UART_BAUD_ERROR_MAX
+	#define UART_BAUD_ERROR_MAX			20
+#endif
+
+#ifndef UART_BAUD_ERROR_FATAL
+	#define UART_BAUD_ERROR_FATAL		0
+#endif
+
+//Baud rate calculation. The UBRR value is rounded to the nearest setting, and double speed (U2X) is used when it gives a smaller error.
+//These are all constant expressions, so they can be used in #if and cost nothing at runtime when the baud rate is a constant.
+#define UART_UBRR_MAX				4095UL
+#define UART_UBRR_1X(baud)			((((F_CPU) + 8UL*(baud)) / (16UL*(baud))) - 1UL)
+#define UART_UBRR_2X(baud)			((((F_CPU) + 4UL*(baud)) / (8UL*(baud))) - 1UL)
+#define UART_ACTUAL_1X(baud)		((F_CPU) / (16UL*(UART_UBRR_1X(baud) + 1UL)))
+#define UART_ACTUAL_2X(baud)		((F_CPU) / (8UL*(UART_UBRR_2X(baud) + 1UL)))
+
+/** The error between the actual and wanted baud rate, in 0.1% steps */
+#define UART_ERROR(actual, baud)	((((actual) > (baud)) ? ((actual) - (baud)) : ((baud) - (actual))) * 1000UL / (baud))
+
+/** 1 if double speed gives a smaller baud rate error than normal speed */
+#define UART_USE_2X(baud)			((UART_UBRR_2X(baud) <= UART_UBRR_MAX) && \
+									 ((UART_UBRR_1X(baud) > UART_UBRR_MAX) || \
+									  (UART_ERROR(UART_ACTUAL_2X(baud), (baud)) < UART_ERROR(UART_ACTUAL_1X(baud), (baud)))))
+
+/** The UBRR value for a baud rate */
+#define UART_UBRR(baud)				(UART_USE_2X(baud) ? UART_UBRR_2X(baud) : UART_UBRR_1X(baud))
+
+/** The baud rate error of the chosen setting, in 0.1% steps */
+#define UART_BAUD_ERROR(baud)		(UART_USE_2X(baud) ? UART_ERROR(UART_ACTUAL_2X(baud), (baud)) : UART_ERROR(UART_ACTUAL_1X(baud), (baud)))
+
+/** The UBRR value with the U2X flag in bit 15, as used by UARTPortInit() */
+#define UART_BAUD_SETTING(baud)		((uint16_t)(UART_UBRR(baud) | (UART_USE_2X(baud) ? 0x8000UL : 0UL)))
 
 //Function definitions
-#define MYUBRR 			(F_CPU/16/UART_BAUD-1)
+#define MYUBRR 						UART_UBRR_1X(UART_BAUD)
 
+//USARTs available on each part
 #if defined (__AVR_ATmega328P__) || defined (__AVR_ATmega328__)
-	#define UARTRXINTON() 	UCSR0B |= (1<<RXCIE0)
-	#define UARTRXINTOFF() 	UCSR0B &= !(1<<RXCIE0)
+	#define UART_HAS_USART0			1
+	#define UART0_REGS				(&UCSR0A)
+	#define UART0_PRR				PRR
+	#define UART0_PRR_BIT			PRUSART0
+	#define UART0_RX_vect			USART_RX_vect
+	#define UART0_UDRE_vect			USART_UDRE_vect
+	#define UART0_TX_vect			USART_TX_vect
+	#define UART_SINGLE_NUMBER		0
 #elif defined (__AVR_ATmega32U4__)
-	#define UARTRXINTON() 	UCSR1B |= (1<<RXCIE1)
-	#define UARTRXINTOFF() 	UCSR1B &= !(1<<RXCIE1)
+	#define UART_HAS_USART1			1
+	#define UART1_REGS				(&UCSR1A)
+	#define UART1_PRR				PRR1
+	#define UART1_PRR_BIT			PRUSART1
+	#define UART1_RX_vect			USART1_RX_vect
+	#define UART1_UDRE_vect			USART1_UDRE_vect
+	#define UART1_TX_vect			USART1_TX_vect
+	#define UART_SINGLE_NUMBER		1
 #elif defined (__AVR_ATmega2561__)
-	#if UART_NUMBER == 0
-		#define UARTRXINTON() 	UCSR0B |= (1<<RXCIE0)
-		#define UARTRXINTOFF() 	UCSR0B &= !(1<<RXCIE0)
-	#elif UART_NUMBER == 1
-		#define UARTRXINTON() 	UCSR1B |= (1<<RXCIE1)
-		#define UARTRXINTOFF() 	UCSR1B &= !(1<<RXCIE1)
-	#elif UART_NUMBER == 2
-		#define UARTRXINTON() 	UCSR2B |= (1<<RXCIE2)
-		#define UARTRXINTOFF() 	UCSR2B &= !(1<<RXCIE2)
-	#elif UART_NUMBER == 3
-		#define UARTRXINTON() 	UCSR3B |= (1<<RXCIE3)
-		#define UARTRXINTOFF() 	UCSR3B &= !(1<<RXCIE3)
+	#define UART_HAS_USART0			1
+	#define UART0_REGS				(&UCSR0A)
+	#define UART0_PRR				PRR0
+	#define UART0_PRR_BIT			PRUSART0
+	#define UART0_RX_vect			USART0_RX_vect
+	#define UART0_UDRE_vect			USART0_UDRE_vect
+	#define UART0_TX_vect			USART0_TX_vect
+	#define UART_HAS_USART1			1
+	#define UART1_REGS				(&UCSR1A)
+	#define UART1_PRR				PRR1
+	#define UART1_PRR_BIT			PRUSART1
+	#define UART1_RX_vect			USART1_RX_vect
+	#define UART1_UDRE_vect			USART1_UDRE_vect
+	#define UART1_TX_vect			USART1_TX_vect
+	#define UART_HAS_USART2			1
+	#define UART2_REGS				(&UCSR2A)
+	#define UART2_PRR				PRR1
+	#define UART2_PRR_BIT			PRUSART2
+	#define UART2_RX_vect			USART2_RX_vect
+	#define UART2_UDRE_vect			USART2_UDRE_vect
+	#define UART2_TX_vect			USART2_TX_vect
+	#define UART_HAS_USART3			1
+	#define UART3_REGS				(&UCSR3A)
+	#define UART3_PRR				PRR1
+	#define UART3_PRR_BIT			PRUSART3
+	#define UART3_RX_vect			USART3_RX_vect
+	#define UART3_UDRE_vect			USART3_UDRE_vect
+	#define UART3_TX_vect			USART3_TX_vect
+	#ifdef UART_NUMBER
+		#define UART_SINGLE_NUMBER	UART_NUMBER
+	#endif
+#else
+	#error: MCU not defined/handled
+#endif
+
+//If no USARTs are enabled, use the single USART setup
+#if !defined(UART0_ENABLE) && !defined(UART1_ENABLE) && !defined(UART2_ENABLE) && !defined(UART3_ENABLE)
+	#if !defined(UART_SINGLE_NUMBER)
+		#error: UART number not defined
+	#elif UART_SINGLE_NUMBER == 0
+		#define UART0_ENABLE		1
+	#elif UART_SINGLE_NUMBER == 1
+		#define UART1_ENABLE		1
+	#elif UART_SINGLE_NUMBER == 2
+		#define UART2_ENABLE		1
+	#elif UART_SINGLE_NUMBER == 3
+		#define UART3_ENABLE		1
 	#else
 		#error: UART number not defined
 	#endif
+#endif
+
+#ifndef UART0_ENABLE
+	#define UART0_ENABLE			0
+#endif
+#ifndef UART1_ENABLE
+	#define UART1_ENABLE			0
+#endif
+#ifndef UART2_ENABLE
+	#define UART2_ENABLE			0
+#endif
+#ifndef UART3_ENABLE
+	#define UART3_ENABLE			0
+#endif
+
+#if ((UART0_ENABLE == 1) && !defined(UART_HAS_USART0)) || ((UART1_ENABLE == 1) && !defined(UART_HAS_USART1)) || \
+	((UART2_ENABLE == 1) && !defined(UART_HAS_USART2)) || ((UART3_ENABLE == 1) && !defined(UART_HAS_USART3))
+	#error: An enabled USART does not exist on this MCU
+#endif
+
+//Per USART settings, these default to the common settings
+#if UART0_ENABLE == 1
+	#ifndef UART0_BAUD
+		#define UART0_BAUD				UART_BAUD
+	#endif
+	#ifndef UART0_TX_BUFFER_SIZE
+		#define UART0_TX_BUFFER_SIZE	UART_TX_BUFFER_SIZE
+	#endif
+	#ifndef UART0_RX_BUFFER_SIZE
+		#define UART0_RX_BUFFER_SIZE	UART_RX_BUFFER_SIZE
+	#endif
+#endif
+#if UART1_ENABLE == 1
+	#ifndef UART1_BAUD
+		#define UART1_BAUD				UART_BAUD
+	#endif
+	#ifndef UART1_TX_BUFFER_SIZE
+		#define UART1_TX_BUFFER_SIZE	UART_TX_BUFFER_SIZE
+	#endif
+	#ifndef UART1_RX_BUFFER_SIZE
+		#define UART1_RX_BUFFER_SIZE	UART_RX_BUFFER_SIZE
+	#endif
+#endif
+#if UART2_ENABLE == 1
+	#ifndef UART2_BAUD
+		#define UART2_BAUD				UART_BAUD
+	#endif
+	#ifndef UART2_TX_BUFFER_SIZE
+		#define UART2_TX_BUFFER_SIZE	UART_TX_BUFFER_SIZE
+	#endif
+	#ifndef UART2_RX_BUFFER_SIZE
+		#define UART2_RX_BUFFER_SIZE	UART_RX_BUFFER_SIZE
+	#endif
+#endif
+#if UART3_ENABLE == 1
+	#ifndef UART3_BAUD
+		#define UART3_BAUD				UART_BAUD
+	#endif
+	#ifndef UART3_TX_BUFFER_SIZE
+		#define UART3_TX_BUFFER_SIZE	UART_TX_BUFFER_SIZE
+	#endif
+	#ifndef UART3_RX_BUFFER_SIZE
+		#define UART3_RX_BUFFER_SIZE	UART_RX_BUFFER_SIZE
+	#endif
+#endif
+
+//Check the baud rate error of each USART
+#if (UART0_ENABLE == 1) && ((UART_UBRR_1X(UART0_BAUD) > UART_UBRR_MAX) || (UART_BAUD_ERROR(UART0_BAUD) > UART_BAUD_ERROR_MAX))
+	#if UART_BAUD_ERROR_FATAL == 1
+		#error: UART0 baud rate cannot be reached with this F_CPU
+	#else
+		#warning: UART0 baud rate error is larger than UART_BAUD_ERROR_MAX
+	#endif
+#endif
+#if (UART1_ENABLE == 1) && ((UART_UBRR_1X(UART1_BAUD) > UART_UBRR_MAX) || (UART_BAUD_ERROR(UART1_BAUD) > UART_BAUD_ERROR_MAX))
+	#if UART_BAUD_ERROR_FATAL == 1
+		#error: UART1 baud rate cannot be reached with this F_CPU
+	#else
+		#warning: UART1 baud rate error is larger than UART_BAUD_ERROR_MAX
+	#endif
+#endif
+#if (UART2_ENABLE == 1) && ((UART_UBRR_1X(UART2_BAUD) > UART_UBRR_MAX) || (UART_BAUD_ERROR(UART2_BAUD) > UART_BAUD_ERROR_MAX))
+	#if UART_BAUD_ERROR_FATAL == 1
+		#error: UART2 baud rate cannot be reached with this F_CPU
+	#else
+		#warning: UART2 baud rate error is larger than UART_BAUD_ERROR_MAX
+	#endif
+#endif
+#if (UART3_ENABLE == 1) && ((UART_UBRR_1X(UART3_BAUD) > UART_UBRR_MAX) || (UART_BAUD_ERROR(UART3_BAUD) > UART_BAUD_ERROR_MAX))
+	#if UART_BAUD_ERROR_FATAL == 1
+		#error: UART3 baud rate cannot be reached with this F_CPU
+	#else
+		#warning: UART3 baud rate error is larger than UART_BAUD_ERROR_MAX
+	#endif
+#endif
+
+#if UART_USE_BUFFERS == 1
+	#define UART_CHECK_BUFFER_SIZE(size)	(((size) & ((size) - 1)) || ((size) > 128) || ((size) < 2))
+	#if ((UART0_ENABLE == 1) && (UART_CHECK_BUFFER_SIZE(UART0_TX_BUFFER_SIZE) || UART_CHECK_BUFFER_SIZE(UART0_RX_BUFFER_SIZE))) || \
+		((UART1_ENABLE == 1) && (UART_CHECK_BUFFER_SIZE(UART1_TX_BUFFER_SIZE) || UART_CHECK_BUFFER_SIZE(UART1_RX_BUFFER_SIZE))) || \
+		((UART2_ENABLE == 1) && (UART_CHECK_BUFFER_SIZE(UART2_TX_BUFFER_SIZE) || UART_CHECK_BUFFER_SIZE(UART2_RX_BUFFER_SIZE))) || \
+		((UART3_ENABLE == 1) && (UART_CHECK_BUFFER_SIZE(UART3_TX_BUFFER_SIZE) || UART_CHECK_BUFFER_SIZE(UART3_RX_BUFFER_SIZE)))
+		#error: UART buffer sizes must be a power of 2 and no more than 128
+	#endif
+#endif
+
+//The USART used for UART_stdout
+#ifndef UART_DEFAULT_NUMBER
+	#if UART0_ENABLE == 1
+		#define UART_DEFAULT_NUMBER	0
+	#elif UART1_ENABLE == 1
+		#define UART_DEFAULT_NUMBER	1
+	#elif UART2_ENABLE == 1
+		#define UART_DEFAULT_NUMBER	2
+	#else
+		#define UART_DEFAULT_NUMBER	3
+	#endif
+#endif
 
+#if UART_DEFAULT_NUMBER == 0
+	#define UART_DEFAULT_PORT		(&UARTPort0)
+	#define UART_DEFAULT_STATE		UARTState0
+	#define UART_DEFAULT_REGS		UART0_REGS
+	#define UART_DEFAULT_RX_vect	UART0_RX_vect
+#elif UART_DEFAULT_NUMBER == 1
+	#define UART_DEFAULT_PORT		(&UARTPort1)
+	#define UART_DEFAULT_STATE		UARTState1
+	#define UART_DEFAULT_REGS		UART1_REGS
+	#define UART_DEFAULT_RX_vect	UART1_RX_vect
+#elif UART_DEFAULT_NUMBER == 2
+	#define UART_DEFAULT_PORT		(&UARTPort2)
+	#define UART_DEFAULT_STATE		UARTState2
+	#define UART_DEFAULT_REGS		UART2_REGS
+	#define UART_DEFAULT_RX_vect	UART2_RX_vect
 #else
-	#error: MCU not defined/handled
+	#define UART_DEFAULT_PORT		(&UARTPort3)
+	#define UART_DEFAULT_STATE		UARTState3
+	#define UART_DEFAULT_REGS		UART3_REGS
+	#define UART_DEFAULT_RX_vect	UART3_RX_vect
+#endif
+
+//Every USART has the same register layout starting at UCSRnA, and the same bit positions
+#define UART_UCSRA				0
+#define UART_UCSRB				1
+#define UART_UCSRC				2
+#define UART_UBRRL				4
+#define UART_UBRRH				5
+#define UART_UDR				6
+
+#define UART_BIT_RXC			7
+#define UART_BIT_TXC			6
+#define UART_BIT_UDRE			5
+#define UART_BIT_U2X			1
+#define UART_BIT_RXCIE			7
+#define UART_BIT_TXCIE			6
+#define UART_BIT_UDRIE			5
+#define UART_BIT_RXEN			4
+#define UART_BIT_TXEN			3
+#define UART_BIT_UCSZ0			1
+
+//The DDRx and PINx registers are just below PORTx
+#define UART_DDR(port)			(*((port) - 1))
+#define UART_PIN(port)			(*((port) - 2))
+
+/** Access a USART register of a port. The ports are const, so when the port is a constant (like &UARTPort1 in the ISRs) this compiles to a direct register access.
+*	Where the port is a function argument, each access is a load of Regs from the port followed by an indirect access.
+*/
+#define UART_REG(port, reg)		((port)->Regs[(reg)])
+
+/** The parts of a USART that change at runtime */
+typedef struct UARTPortState
+{
+#if UART_USE_BUFFERS == 1
+	//The head is only written by the producer and the tail only by the consumer, so no locking is needed.
+	//The indexes are free running, (head - tail) is the number of bytes in the buffer.
+	volatile uint8_t TxHead;
+	volatile uint8_t TxTail;
+	volatile uint8_t RxHead;
+	volatile uint8_t RxTail;
+	volatile uint8_t RxOverflowCount;
+
+#if UART_USE_RX_HANDLER == 1
+	/**If set, received bytes are passed to this function from the RX ISR instead of being put in the RX buffer*/
+	void (*RxHandler) (void *HandlerData, uint8_t c);
+
+	/**Passed to RxHandler*/
+	void *RxHandlerData;
+#endif
+#endif
+
+#if UART_USE_FLOW_CONTROL == 1
+	/**PORTx register and pin mask of the RTS output (mask is 0 if not used). RTS is low when the RX buffer has room.*/
+	volatile uint8_t *RtsPort;
+	uint8_t RtsMask;
+
+	/**PORTx register and pin mask of the CTS input (mask is 0 if not used). Data is only sent while CTS is low.*/
+	volatile uint8_t *CtsPort;
+	uint8_t CtsMask;
+
+	/**PORTx register and pin mask of the RS-485 driver enable output (mask is 0 if not used). DE is high while sending.*/
+	volatile uint8_t *DePort;
+	uint8_t DeMask;
+#endif
+
+	/**The stdio stream for this USART*/
+	FILE Stream;
+} UARTPortState;
+
+/** One USART. None of this changes at runtime, so the ports are const and the ISRs get the register and buffer addresses as constants. */
+typedef struct UARTPort
+{
+	/**The first register (UCSRnA) of the USART*/
+	volatile uint8_t *Regs;
+
+#if UART_USE_BUFFERS == 1
+	/**The TX ring buffer*/
+	volatile uint8_t *TxBuffer;
+
+	/**The RX ring buffer*/
+	volatile uint8_t *RxBuffer;
+
+	/**Size of the TX ring buffer - 1*/
+	uint8_t TxMask;
+
+	/**Size of the RX ring buffer - 1*/
+	uint8_t RxMask;
 #endif
 
-extern FILE UART_stdout;
+	/**The runtime state of the USART*/
+	UARTPortState *State;
+} UARTPort;
+
+#if UART0_ENABLE == 1
+extern const UARTPort UARTPort0;
+extern UARTPortState UARTState0;
+#endif
+#if UART1_ENABLE == 1
+extern const UARTPort UARTPort1;
+extern UARTPortState UARTState1;
+#endif
+#if UART2_ENABLE == 1
+extern const UARTPort UARTPort2;
+extern UARTPortState UARTState2;
+#endif
+#if UART3_ENABLE == 1
+extern const UARTPort UARTPort3;
+extern UARTPortState UARTState3;
+#endif
+
+/** The stdio stream of the default USART. Use &UART_stdout as before. This is a statically initialized FILE, so &UART_stdout
+*	can be used in initializers and given to stdout before UARTinit(), but nothing is sent until UARTinit() has been called.
+*/
+#define UART_stdout				(UART_DEFAULT_STATE.Stream)
+
+/** The stdio stream of a port
+*	\param[in] port The port, for example &UARTPort2.
+*/
+#define UART_STREAM(port)		(&(port)->State->Stream)
+
+#define UARTRXINTON() 			UART_DEFAULT_REGS[UART_UCSRB] |= (1<<UART_BIT_RXCIE)
+#define UARTRXINTOFF() 			UART_DEFAULT_REGS[UART_UCSRB] &= ~(1<<UART_BIT_RXCIE)
 
+/** Initializes all enabled USARTs and their stdio streams */
 void UARTinit(void);
+
+/** Change the baud rate of a port at runtime, for example after a higher rate was negotiated. Double speed is used if it gives a smaller error.
+*	The TX buffer is emptied first, but the byte in the USART shift register may still be sending, so wait a character time before calling this if that matters.
+*	\param[in] port The port to change.
+*	\param[in] baud The new baud rate.
+*
+*	\return The baud rate error in 0.1% steps, or 0xFFFF if the rate cannot be reached (the port is not changed)
+*/
+uint16_t UARTSetBaud(const UARTPort *port, uint32_t baud);
+
+/** Send a character for stdio. '\n' is sent as "\r\n".
+*	\param[in] c The character to send.
+*	\param[in] stream The stream of the port to send on (from UART_STREAM()). NULL uses the default port.
+*
+*	\return 0 if the character was sent or queued
+*/
 int UARTPutChar(char c, FILE *stream);
 
+/** Send a block of bytes from RAM, bypassing stdio. No '\n' to '\r\n' conversion is done.
+*	With buffers, the bytes are copied into the TX buffer as one block and the ISR is started once, instead of once per byte.
+*	\param[in] port The port to send on.
+*	\param[in] *buf The bytes to send.
+*	\param[in] len The number of bytes to send.
+*
+*	\return The number of bytes sent or queued. This is less than len only if UART_TX_BLOCK_WHEN_FULL is 0 and the buffer filled up.
+*/
+uint16_t UARTWrite(const UARTPort *port, const uint8_t *buf, uint16_t len);
+
+/** Send a block of bytes from program memory, bypassing stdio. Works the same as UARTWrite().
+*	\param[in] port The port to send on.
+*	\param[in] *buf The bytes to send, in program memory.
+*	\param[in] len The number of bytes to send.
+*
+*	\return The number of bytes sent or queued
+*/
+uint16_t UARTWrite_P(const UARTPort *port, const uint8_t *buf, uint16_t len);
+
+#if UART_USE_BUFFERS == 1
+/** Get a character for stdio. This waits until a character is received.
+*	\param[in] stream The stream of the port to receive on. NULL uses the default port.
+*
+*	\return The received character
+*/
+int UARTGetChar(FILE *stream);
+
+/** Add a byte to the TX buffer without waiting. No '\n' to '\r\n' conversion is done.
+*	\param[in] port The port to send on.
+*	\param[in] c The byte to send.
+*
+*	\return 1 if the byte was queued, 0 if the TX buffer is full
+*/
+uint8_t UARTPutByte(const UARTPort *port, uint8_t c);
+
+/** Get a byte from the RX buffer without waiting.
+*	\param[in] port The port to receive on.
+*
+*	\return The received byte, or -1 if the RX buffer is empty
+*/
+int16_t UARTGetByte(const UARTPort *port);
+
+/** Returns the number of bytes waiting in the RX buffer of a port */
+uint8_t UARTRxAvailable(const UARTPort *port);
+
+/** Returns the number of bytes dropped because the RX buffer of a port was full. Reading this clears the count. */
+uint8_t UARTRxOverflows(const UARTPort *port);
+
+/** Waits until all bytes in the TX buffer of a port have been handed to the USART */
+void UARTFlush(const UARTPort *port);
+
+#if UART_USE_FLOW_CONTROL == 1
+/** Turn on hardware flow control for a port. RTS is raised when the RX buffer is almost full and lowered again when it is half empty.
+*	Sending stops while CTS is high. When CTS goes low again, call UARTCheckCTS() (for example from a pin change interrupt) to restart sending,
+*	otherwise it restarts on the next write or UARTFlush().
+*	\param[in] port The port.
+*	\param[in] RtsPort The PORTx register of the RTS output (for example &PORTD), or NULL to not use RTS.
+*	\param[in] RtsPin The pin number of the RTS output.
+*	\param[in] CtsPort The PORTx register of the CTS input, or NULL to not use CTS.
+*	\param[in] CtsPin The pin number of the CTS input.
+*/
+void UARTSetFlowControl(const UARTPort *port, volatile uint8_t *RtsPort, uint8_t RtsPin, volatile uint8_t *CtsPort, uint8_t CtsPin);
+
+/** Turn on RS-485 driver enable control for a port. DE is set before each byte is sent and cleared from the TX complete interrupt once the TX buffer is empty.
+*	\param[in] port The port.
+*	\param[in] DePort The PORTx register of the DE output (for example &PORTD), or NULL to turn this off.
+*	\param[in] DePin The pin number of the DE output.
+*/
+void UARTSetRS485(const UARTPort *port, volatile uint8_t *DePort, uint8_t DePin);
+
+/** Restart sending on a port that was stopped by CTS. This can be called from an ISR.
+*	\param[in] port The port.
+*/
+void UARTCheckCTS(const UARTPort *port);
+#endif
+
+#if UART_USE_RX_HANDLER == 1
+/** Pass received bytes of a port to a function instead of the RX buffer. The function is called from the RX ISR, so keep it short.
+*	\param[in] port The port.
+*	\param[in] handler The function to call for each received byte, or NULL to go back to using the RX buffer.
+*	\param[in] HandlerData Passed to the handler as its first argument.
+*/
+void UARTSetRxHandler(const UARTPort *port, void (*handler) (void *HandlerData, uint8_t c), void *HandlerData);
+#endif
+#endif
+
 #endif
 
 /** @} */
@@ -0,0 +1,413 @@
+/*   This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+*	\brief		Cycle count benchmarks
+*	\author		Pat Satyshur
+*	\version	1.0
+*	\date		4/27/2013
+*	\copyright	Copyright 2013, Pat Satyshur
+*	\ingroup 	hardware
+*
+*	@{
+*/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include "bench.h"
+
+#if BENCH_RINGBUFFER == 1
+	#include <LUFA-120730/Drivers/Misc/RingBuffer.h>
+#endif
+
+#if BENCH_I2C == 1
+	#include "i2c_bus.h"
+#endif
+
+#if BENCH_UART == 1
+	#include "UART.h"
+	#if UART_USE_BUFFERS != 1
+		#error: BENCH_UART needs UART_USE_BUFFERS set to 1
+	#endif
+#endif
+
+#if BENCH_SPI == 1
+	#include "spi.h"
+#endif
+
+//Number of calls timed in each loop
+#define BENCH_LOOP_COUNT			32
+
+uint16_t BenchOverhead;
+
+//Timer1 settings from before BenchBegin()
+static uint8_t BenchSavedTCCR1A;
+static uint8_t BenchSavedTCCR1B;
+static uint8_t BenchSavedTIMSK1;
+
+void BenchBegin(void)
+{
+	BenchSavedTCCR1A = TCCR1A;
+	BenchSavedTCCR1B = TCCR1B;
+	BenchSavedTIMSK1 = TIMSK1;
+
+	//Normal mode, no prescaler, no interrupts
+	TIMSK1 = 0;
+	TCCR1A = 0;
+	TCCR1B = (1<<CS10);
+
+	BenchOverhead = 0;
+	BenchStart();
+	BenchOverhead = BenchStop();
+}
+
+void BenchEnd(void)
+{
+	TCCR1B = 0;
+	TCCR1A = BenchSavedTCCR1A;
+	TIFR1 = 0xFF;
+	TIMSK1 = BenchSavedTIMSK1;
+	TCCR1B = BenchSavedTCCR1B;
+}
+
+void BenchReport(const char *name, uint16_t cycles, uint16_t count)
+{
+	uint32_t tenths;
+
+	printf_P(PSTR("%S: "), name);
+	if(cycles == BENCH_OVERFLOW)
+	{
+		printf_P(PSTR("overflow\n"));
+		return;
+	}
+
+	printf_P(PSTR("%u cycles"), cycles);
+	if(count > 1)
+	{
+		tenths = ((uint32_t)cycles * 10 + count / 2) / count;
+		printf_P(PSTR(" (%lu.%lu per call)"), tenths / 10, tenths % 10);
+	}
+	printf_P(PSTR("\n"));
+}
+
+#if BENCH_RINGBUFFER == 1
+static RingBuffer_t BenchRingBuffer;
+static uint8_t BenchRingBufferData[64];
+
+//Fill half the buffer and empty it again. The loop is counted too, so compare the two builds rather than the absolute numbers.
+static void BenchRunRingBuffer(void)
+{
+	volatile uint16_t count;
+	volatile uint8_t c;
+	uint16_t cycles;
+	uint8_t sreg = SREG;
+	uint8_t i;
+
+	#if defined(RING_BUFFER_LOCK_FREE)
+	printf_P(PSTR("Ring buffer (lock free):\n"));
+	#else
+	printf_P(PSTR("Ring buffer:\n"));
+	#endif
+
+	RingBuffer_InitBuffer(&BenchRingBuffer, BenchRingBufferData, sizeof(BenchRingBufferData));
+
+	cli();
+	BenchStart();
+	for(i = 0; i < BENCH_LOOP_COUNT; i++)
+	{
+		RingBuffer_Insert(&BenchRingBuffer, i);
+	}
+	cycles = BenchStop();
+	SREG = sreg;
+	BenchReport(PSTR("RingBuffer_Insert"), cycles, BENCH_LOOP_COUNT);
+
+	cli();
+	BenchStart();
+	for(i = 0; i < BENCH_LOOP_COUNT; i++)
+	{
+		count = RingBuffer_GetCount(&BenchRingBuffer);
+	}
+	cycles = BenchStop();
+	SREG = sreg;
+	BenchReport(PSTR("RingBuffer_GetCount"), cycles, BENCH_LOOP_COUNT);
+
+	cli();
+	BenchStart();
+	for(i = 0; i < BENCH_LOOP_COUNT; i++)
+	{
+		c = RingBuffer_Remove(&BenchRingBuffer);
+	}
+	cycles = BenchStop();
+	SREG = sreg;
+	BenchReport(PSTR("RingBuffer_Remove"), cycles, BENCH_LOOP_COUNT);
+
+	(void)count;
+	(void)c;
+}
+#endif
+
+#if BENCH_I2C == 1
+//Time one register read on a backend. The I2C clock sets most of the time, the rest is the driver.
+static void BenchRunI2CBus(const I2CBus *Bus, const char *name)
+{
+	uint8_t data[BENCH_I2C_LENGTH];
+	uint16_t cycles;
+	uint8_t status;
+	uint8_t sreg = SREG;
+
+	cli();
+	BenchStart();
+	status = I2CBus_ReadRegs(Bus, BENCH_I2C_ADDRESS, BENCH_I2C_REG, data, BENCH_I2C_LENGTH);
+	cycles = BenchStop();
+	SREG = sreg;
+
+	BenchReport(name, cycles, 1);
+	if(status != I2C_STAT_OK)
+	{
+		printf_P(PSTR("I2C status 0x%02X, the device did not answer\n"), status);
+	}
+}
+
+static void BenchRunI2C(void)
+{
+	printf_P(PSTR("I2C, %u registers from 0x%02X:\n"), BENCH_I2C_LENGTH, BENCH_I2C_ADDRESS);
+
+	#if I2C_BUS_USE_TWI == 1
+	BenchRunI2CBus(&I2CBus_TWI, PSTR("I2CBus_ReadRegs (TWI)"));
+	#endif
+	#if I2C_BUS_USE_LUFA == 1
+	BenchRunI2CBus(&I2CBus_LUFA, PSTR("I2CBus_ReadRegs (LUFA)"));
+	#endif
+	#if I2C_BUS_USE_SOFT == 1
+	BenchRunI2CBus(&I2CBus_Soft, PSTR("I2CBus_ReadRegs (soft)"));
+	#endif
+}
+#endif
+
+#if BENCH_UART == 1
+//Ways of sending the payload
+#define BENCH_UART_WRITE			0
+#define BENCH_UART_PUTCHAR			1
+#define BENCH_UART_PRINTF			2
+
+//Iterations of the idle loop timed to find its cycles per iteration, and the most it waits for the TX buffer to drain
+#define BENCH_UART_IDLE_CAL			256
+#define BENCH_UART_IDLE_LIMIT		2000000UL
+
+//Timer1 overflows counted by the idle loop, for times longer than Timer1 can count
+static uint16_t BenchOverflows;
+
+//Spin until the last byte has left the USART (TXC). The ISRs run in between, so the iterations show how much CPU time was left over.
+//With RS-485 driver enable on the port the TXC ISR clears the flag, and this only ends at the limit.
+static uint32_t BenchUARTIdle(const UARTPort *port, uint32_t limit) __attribute__ ((noinline));
+static uint32_t BenchUARTIdle(const UARTPort *port, uint32_t limit)
+{
+	uint32_t idle = 0;
+
+	while(((UART_REG(port, UART_UCSRA) & (1<<UART_BIT_TXC)) == 0) && (idle < limit))
+	{
+		if(TIFR1 & (1<<TOV1))
+		{
+			TIFR1 = (1<<TOV1);
+			BenchOverflows++;
+		}
+		idle++;
+	}
+	return idle;
+}
+
+//Cycles since BenchStart(), including the overflows counted by BenchUARTIdle()
+static uint32_t BenchElapsed(void)
+{
+	uint16_t t = TCNT1;
+
+	if(TIFR1 & (1<<TOV1))
+	{
+		TIFR1 = (1<<TOV1);
+		BenchOverflows++;
+		t = TCNT1;
+	}
+	return ((uint32_t)BenchOverflows << 16) + t;
+}
+
+//Wait until everything sent before has left the USART, then clear TXC so it only sets at the end of the next payload
+static void BenchUARTIdleStart(const UARTPort *port)
+{
+	UARTFlush(port);
+	BenchUARTIdle(port, BENCH_UART_IDLE_LIMIT);
+	UART_REG(port, UART_UCSRA) = (UART_REG(port, UART_UCSRA) & (1<<UART_BIT_U2X)) | (1<<UART_BIT_TXC);
+}
+
+//Send the payload one way. The call is timed with interrupts off, then interrupts are turned on while the UDRE ISR drains the buffer.
+//Throughput is the payload over the time from the call until the last byte is out, CPU use is the share of that time not left to the idle loop.
+static void BenchRunUARTCase(const char *name, uint8_t method, const char *data, uint8_t len, uint16_t IdleCal)
+{
+	const UARTPort *port = UART_DEFAULT_PORT;
+	uint16_t cycles;
+	uint32_t idle;
+	uint32_t wall;
+	uint32_t busy;
+	uint32_t tenths;
+	uint8_t sreg = SREG;
+	uint8_t i;
+
+	BenchUARTIdleStart(port);
+
+	cli();
+	BenchOverflows = 0;
+	BenchStart();
+	switch(method)
+	{
+		case BENCH_UART_WRITE:
+			UARTWrite(port, (const uint8_t *)data, len);
+			break;
+
+		case BENCH_UART_PUTCHAR:
+			for(i = 0; i < len; i++)
+			{
+				UARTPutChar(data[i], UART_STREAM(port));
+			}
+			break;
+
+		default:
+			fprintf_P(&UART_stdout, PSTR("%s"), data);
+			break;
+	}
+	cycles = BenchStop();
+	sei();
+	idle = BenchUARTIdle(port, BENCH_UART_IDLE_LIMIT);
+	wall = BenchElapsed();
+	SREG = sreg;
+
+	printf_P(PSTR("\n"));
+	BenchReport(name, cycles, len);
+
+	busy = (uint32_t)(((uint64_t)idle * IdleCal) / BENCH_UART_IDLE_CAL);
+	busy = (busy < wall) ? (wall - busy) : 0;
+	tenths = (uint32_t)(((uint64_t)busy * 1000 + wall / 2) / wall);
+	printf_P(PSTR("  drained in %lu cycles, %lu bytes/s, CPU %lu.%lu%%\n"), wall, (uint32_t)(((uint64_t)len * F_CPU) / wall), tenths / 10, tenths % 10);
+}
+
+//Send a line of text with UARTWrite(), a UARTPutChar() loop and printf through UART_stdout
+static void BenchRunUART(void)
+{
+	const UARTPort *port = UART_DEFAULT_PORT;
+	char data[BENCH_UART_LENGTH + 1];
+	uint16_t IdleCal;
+	uint8_t len = BENCH_UART_LENGTH;
+	uint8_t sreg = SREG;
+	uint8_t i;
+
+	if(len > port->TxMask + 1)
+	{
+		len = port->TxMask + 1;
+	}
+	for(i = 0; i < len; i++)
+	{
+		data[i] = 'a' + (i % 26);
+	}
+	data[len] = 0;
+
+	printf_P(PSTR("UART, %u bytes into an empty TX buffer:\n"), len);
+
+	//Cycles for BENCH_UART_IDLE_CAL iterations of the idle loop with nothing else running. TXC stays clear as nothing is being sent.
+	BenchUARTIdleStart(port);
+	cli();
+	BenchStart();
+	BenchUARTIdle(port, BENCH_UART_IDLE_CAL);
+	IdleCal = BenchStop();
+	SREG = sreg;
+
+	BenchRunUARTCase(PSTR("UARTWrite"), BENCH_UART_WRITE, data, len, IdleCal);
+	BenchRunUARTCase(PSTR("UARTPutChar loop"), BENCH_UART_PUTCHAR, data, len, IdleCal);
+	BenchRunUARTCase(PSTR("printf to UART_stdout"), BENCH_UART_PRINTF, data, len, IdleCal);
+}
+#endif
+
+#if BENCH_SPI == 1
+//Transfer the same block both ways at the SCK rate that is set now. At fosc/2 and fosc/4 the time between bytes is what the code can change.
+static void BenchRunSPI(void)
+{
+	uint8_t tx[BENCH_SPI_LENGTH];
+	uint8_t rx[BENCH_SPI_LENGTH];
+	uint16_t cycles;
+	uint16_t i;
+	uint8_t sreg = SREG;
+
+	for(i = 0; i < BENCH_SPI_LENGTH; i++)
+	{
+		tx[i] = i;
+	}
+
+	printf_P(PSTR("SPI, %u bytes, clock setting %u:\n"), BENCH_SPI_LENGTH, SPIGetClock());
+
+	cli();
+	BenchStart();
+	SPITransfer(tx, rx, BENCH_SPI_LENGTH);
+	cycles = BenchStop();
+	SREG = sreg;
+	BenchReport(PSTR("SPITransfer"), cycles, BENCH_SPI_LENGTH);
+
+	cli();
+	BenchStart();
+	for(i = 0; i < BENCH_SPI_LENGTH; i++)
+	{
+		rx[i] = SPISendByte(tx[i]);
+	}
+	cycles = BenchStop();
+	SREG = sreg;
+	BenchReport(PSTR("SPISendByte loop"), cycles, BENCH_SPI_LENGTH);
+
+	#if SPI_USE_USART == 1
+	cli();
+	BenchStart();
+	SPIUSARTTransfer(tx, rx, BENCH_SPI_LENGTH);
+	cycles = BenchStop();
+	SREG = sreg;
+	BenchReport(PSTR("SPIUSARTTransfer"), cycles, BENCH_SPI_LENGTH);
+	#endif
+}
+#endif
+
+void BenchRun(void)
+{
+	uint8_t sreg = SREG;
+
+	cli();
+	BenchBegin();
+	SREG = sreg;
+	printf_P(PSTR("Benchmarks at %lu Hz, %u cycles overhead removed\n"), (uint32_t)F_CPU, BenchOverhead);
+
+#if BENCH_RINGBUFFER == 1
+	BenchRunRingBuffer();
+#endif
+#if BENCH_I2C == 1
+	BenchRunI2C();
+#endif
+#if BENCH_UART == 1
+	BenchRunUART();
+#endif
+#if BENCH_SPI == 1
+	BenchRunSPI();
+#endif
+
+	cli();
+	BenchEnd();
+	SREG = sreg;
+}
+
+/** @} */
@@ -0,0 +1,144 @@
+/*   This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+*	\brief		Cycle count benchmarks header file
+*	\author		Pat Satyshur
+*	\version	1.0
+*	\date		4/27/2013
+*	\copyright	Copyright 2013, Pat Satyshur
+*	\ingroup 	hardware
+*
+*	Times code in CPU cycles with Timer1 running at F_CPU. BenchRun() runs the benchmarks that are turned on below and prints the
+*	results with printf, so it can be run from the 'bench' command (see command.h) or from main().
+*	Timer1 is taken over while the benchmarks run and its settings are put back after. One measurement can be up to 65534 cycles.
+*
+*	To time your own code:
+*	\code
+*	BenchBegin();
+*	BenchStart();
+*	SomeFunction();
+*	BenchReport(PSTR("SomeFunction"), BenchStop(), 1);
+*	BenchEnd();
+*	\endcode
+*
+*	@{
+*/
+
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <inttypes.h>
+#include <avr/io.h>
+#include "config.h"
+
+/*These settings can be defined in your user code to pick the benchmarks BenchRun() runs
+ * #define BENCH_RINGBUFFER			0		//Set to 1 to time the LUFA ring buffer. Build once with and once without RING_BUFFER_LOCK_FREE to compare.
+ * #define BENCH_I2C					0		//Set to 1 to time I2CBus_ReadRegs() on each I2C backend that is built (see i2c_bus.h). The backends must be initialized first.
+ * #define BENCH_I2C_ADDRESS			0x68	//7-bit address of a device on the bus to read from
+ * #define BENCH_I2C_REG				0x00	//First register to read
+ * #define BENCH_I2C_LENGTH				2		//Number of registers to read. Keep the transfer under 65534 cycles (about 4ms at 16MHz).
+ * #define BENCH_UART					0		//Set to 1 to compare UARTWrite(), a UARTPutChar() loop and printf on the default port (needs UART_USE_BUFFERS).
+ *														//Prints the cycles of each call, and the bytes/s and CPU use while the TX ISR sends the bytes. Interrupts are on while it sends.
+ * #define BENCH_UART_LENGTH			16		//Number of bytes to send, no more than the TX buffer holds
+ * #define BENCH_SPI					0		//Set to 1 to time SPITransfer() against a SPISendByte() loop. SPI must be set up first, no device is selected.
+ * #define BENCH_SPI_LENGTH				32		//Number of bytes to transfer
+ */
+
+#ifndef BENCH_RINGBUFFER
+	#define BENCH_RINGBUFFER		0
+#endif
+
+#ifndef BENCH_I2C
+	#define BENCH_I2C				0
+#endif
+
+#if BENCH_I2C == 1
+	#ifndef BENCH_I2C_ADDRESS
+		#define BENCH_I2C_ADDRESS	0x68
+	#endif
+	#ifndef BENCH_I2C_REG
+		#define BENCH_I2C_REG		0x00
+	#endif
+	#ifndef BENCH_I2C_LENGTH
+		#define BENCH_I2C_LENGTH	2
+	#endif
+#endif
+
+#ifndef BENCH_UART
+	#define BENCH_UART				0
+#endif
+
+#if BENCH_UART == 1
+	#ifndef BENCH_UART_LENGTH
+		#define BENCH_UART_LENGTH	16
+	#endif
+#endif
+
+#ifndef BENCH_SPI
+	#define BENCH_SPI				0
+#endif
+
+#if BENCH_SPI == 1
+	#ifndef BENCH_SPI_LENGTH
+		#define BENCH_SPI_LENGTH	32
+	#endif
+#endif
+
+/** Returned by BenchStop() if Timer1 overflowed */
+#define BENCH_OVERFLOW				0xFFFF
+
+/** Cycles taken by BenchStart() and BenchStop() themselves, measured by BenchBegin() */
+extern uint16_t BenchOverhead;
+
+/** Take over Timer1 and measure the overhead of a measurement. Interrupts should be off while timing, or the ISRs are counted too. */
+void BenchBegin(void);
+
+/** Give Timer1 back, with the settings it had before BenchBegin() */
+void BenchEnd(void);
+
+/** Start a measurement */
+static inline void BenchStart(void)
+{
+	TIFR1 = (1<<TOV1);
+	TCNT1 = 0;
+}
+
+/** End a measurement
+*	\return The cycles since BenchStart(), or BENCH_OVERFLOW if it took longer than Timer1 can count
+*/
+static inline uint16_t BenchStop(void)
+{
+	uint16_t cycles = TCNT1;
+
+	if((TIFR1 & (1<<TOV1)) || (cycles >= BENCH_OVERFLOW))
+	{
+		return BENCH_OVERFLOW;
+	}
+	return cycles - BenchOverhead;
+}
+
+/** Print a result as "name: cycles (cycles per call)"
+*	\param[in] *name The name of what was timed, in program memory.
+*	\param[in] cycles The result of BenchStop().
+*	\param[in] count The number of calls that were timed, the cycles per call are printed if this is more than 1.
+*/
+void BenchReport(const char *name, uint16_t cycles, uint16_t count);
+
+/** Run all benchmarks that are turned on and print the results. Interrupts are turned off during each measurement, but not while printing. */
+void BenchRun(void);
+
+#endif
+
+/** @} */
@@ -67,8 +67,6 @@ static void SaveOldCommand(void);
 //---------------------------------------------------------------------------------------------
 //Common commands are defined here
 //---------------------------------------------------------------------------------------------
-uint8_t NumCommonCommands = 2;	//Total number of common commands
-
 //Help Function
 static int HELP_C (void);
 const char _F1_NAME_COMMON[] PROGMEM 			= "help";
@@ -81,11 +79,35 @@ const char _F2_NAME_COMMON[] PROGMEM 			= "stat";
 const char _F2_DESCRIPTION_COMMON[] PROGMEM 	= "Show Status of CPU";
 const char _F2_HELPTEXT_COMMON[] PROGMEM 		= "'stat' has no parameters" ;
 
+#if COMMAND_STAT_SHOW_MEM_USAGE == 1
+//Memory Usage Function
+static int MEM_C (void);
+const char _F3_NAME_COMMON[] PROGMEM 			= "mem";
+const char _F3_DESCRIPTION_COMMON[] PROGMEM 	= "Show RAM usage";
+const char _F3_HELPTEXT_COMMON[] PROGMEM 		= "'mem' has no parameters" ;
+#endif
+
+#if COMMAND_BENCH == 1
+//Benchmark Function
+static int BENCH_C (void);
+const char _F4_NAME_COMMON[] PROGMEM 			= "bench";
+const char _F4_DESCRIPTION_COMMON[] PROGMEM 	= "Run the cycle count benchmarks";
+const char _F4_HELPTEXT_COMMON[] PROGMEM 		= "'bench' has no parameters" ;
+#endif
+
 static const CommandListItem CommonCommandList[] PROGMEM =
 {
 	{ _F1_NAME_COMMON, 0,  1, HELP_C,	_F1_DESCRIPTION_COMMON, _F1_HELPTEXT_COMMON },
-	{ _F2_NAME_COMMON, 0,  0, STAT_C,	_F2_DESCRIPTION_COMMON, _F2_HELPTEXT_COMMON }
+	{ _F2_NAME_COMMON, 0,  0, STAT_C,	_F2_DESCRIPTION_COMMON, _F2_HELPTEXT_COMMON },
+#if COMMAND_STAT_SHOW_MEM_USAGE == 1
+	{ _F3_NAME_COMMON, 0,  0, MEM_C,	_F3_DESCRIPTION_COMMON, _F3_HELPTEXT_COMMON },
+#endif
+#if COMMAND_BENCH == 1
+	{ _F4_NAME_COMMON, 0,  0, BENCH_C,	_F4_DESCRIPTION_COMMON, _F4_HELPTEXT_COMMON },
+#endif
 };
+
+uint8_t NumCommonCommands = sizeof(CommonCommandList) / sizeof(CommonCommandList[0]);	//Total number of common commands
 //---------------------------------------------------------------------------------------------
 //End of common command definitions
 //---------------------------------------------------------------------------------------------
@@ -564,7 +586,24 @@ static int STAT_C (void)
 	printf_P(PSTR("--------------------------------------------------\n"));
 	
 	#if COMMAND_STAT_SHOW_MEM_USAGE == 1
-	printf_P(PSTR("Free memory: %d bytes\n"), StackCount());
+	printf_P(PSTR("Free memory: %u bytes, "), StackCount());
+	if(MemGetMinMargin() == MEM_WATCH_NONE)
+	{
+		printf_P(PSTR("min n/a\n"));
+	}
+	else
+	{
+		printf_P(PSTR("min %u bytes\n"), MemGetMinMargin());
+	}
+	printf_P(PSTR("Heap/stack pointer margin: %u bytes\n"), MemHeapStackMargin());
+	#endif
+
+	#if COMMAND_STAT_SHOW_MEM_POOLS == 1
+	printf_P(PSTR("Memory pools:\n"));
+	for(MemPool *pool = MemPoolFirst(); pool != NULL; pool = pool->Next)
+	{
+		printf_P(PSTR("%S: %u of %u blocks free, %u most used (%u bytes each)\n"), pool->Name, pool->FreeBlocks, pool->NumBlocks, MemPoolMaxUsed(pool), pool->BlockSize);
+	}
 	#endif
 	/*
 	printf_P(PSTR("Clocks:\n"));
@@ -586,4 +625,34 @@ static int STAT_C (void)
 	#endif
 	return 0;
 }
+
+#if COMMAND_STAT_SHOW_MEM_USAGE == 1
+static int MEM_C (void)
+{
+	MemUsage usage;
+
+	MemGetUsage(&usage);
+	printf_P(PSTR("--------------------------------------------------\n"));
+	printf_P(PSTR("RAM Usage:\n"));
+	printf_P(PSTR("--------------------------------------------------\n"));
+	printf_P(PSTR(".data:     %5u bytes\n"), usage.Data);
+	printf_P(PSTR(".bss:      %5u bytes\n"), usage.Bss);
+	printf_P(PSTR(".noinit:   %5u bytes\n"), usage.Noinit);
+	printf_P(PSTR("Heap:      %5u bytes\n"), usage.Heap);
+	printf_P(PSTR("Stack:     %5u bytes (max %u)\n"), usage.Stack, usage.StackMax);
+	printf_P(PSTR("Free:      %5u bytes\n"), usage.Free);
+	return 0;
+}
+#endif
+
+#if COMMAND_BENCH == 1
+static int BENCH_C (void)
+{
+	printf_P(PSTR("--------------------------------------------------\n"));
+	printf_P(PSTR("Benchmarks:\n"));
+	printf_P(PSTR("--------------------------------------------------\n"));
+	BenchRun();
+	return 0;
+}
+#endif
 /** @} */
\ No newline at end of file
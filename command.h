@@ -37,7 +37,9 @@
 /*These setting must be defined in your user code to use the command interpreter module
  * #define COMMAND_USER_CONFIG								//Define this in your user code to disable the above error.
  * #define COMMAND_STAT_SHOW_COMPILE_STRING			1		//Set to 1 to output the compile date/time string in the stat function					
- * #define COMMAND_STAT_SHOW_MEM_USAGE				1		//Set to 1 to show the memory usage in the stat function. NOTE: if this is enabled, the mem_usage.c must be included in the makefile
+ * #define COMMAND_STAT_SHOW_MEM_USAGE				1		//Set to 1 to show the memory usage in the stat function and add the 'mem' command. NOTE: if this is enabled, the mem_usage.c must be included in the makefile
+ * #define COMMAND_STAT_SHOW_MEM_POOLS				0		//Set to 1 to show the free and most used blocks of each memory pool in the stat function. NOTE: if this is enabled, the mem_pool.c must be included in the makefile
+ * #define COMMAND_BENCH							0		//Set to 1 to add the 'bench' command, which runs the benchmarks turned on in bench.h. NOTE: if this is enabled, the bench.c must be included in the makefile
  * 
  * //Based on the setup above
  * #if COMMAND_STAT_SHOW_COMPILE_STRING == 1
@@ -47,6 +49,14 @@
  * #if COMMAND_STAT_SHOW_MEM_USAGE == 1
  * #include "mem_usage.h"									//The header that contains StackCount()
  * #endif
+ *
+ * #if COMMAND_STAT_SHOW_MEM_POOLS == 1
+ * #include "mem_pool.h"									//The header that contains MemPoolFirst()
+ * #endif
+ *
+ * #if COMMAND_BENCH == 1
+ * #include "bench.h"										//The header that contains BenchRun()
+ * #endif
  */
 
 #define COMMAND_MAX_DISPLAY_LENGTH	10
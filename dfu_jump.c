@@ -26,35 +26,136 @@
 *	@{
 */
 
+#include <avr/boot.h>
 #include "dfu_jump.h"
 
 uint32_t Boot_Key ATTR_NO_INIT;
 
+//The BOOTSZ1:0 bits of the high fuse
+#define BOOTSZ_MASK		0x06
+#define BOOTSZ_SHIFT	1
+
+uint32_t BootloaderStartAddress(void)
+{
+#ifdef BOOTLOADER_START_ADDRESS
+	return BOOTLOADER_START_ADDRESS;
+#else
+	uint8_t bootsz = (boot_lock_fuse_bits_get(GET_HIGH_FUSE_BITS) & BOOTSZ_MASK) >> BOOTSZ_SHIFT;
+
+	//BOOTSZ = 11 is the smallest boot section, 00 is the biggest
+	return ((uint32_t)FLASHEND + 1) - ((uint32_t)BOOTLOADER_MIN_SIZE << (3 - bootsz));
+#endif
+}
+
+//Function pointers hold word addresses, so the byte address is halved
+static void Bootloader_Start(void)
+{
+	((void (*)(void))(uint16_t)(BootloaderStartAddress() >> 1))();
+}
+
+#if DFU_JUMP_DIRECT == 1
+//Without a reset the peripherals keep running. The bootloader has no handlers for their vectors, so an
+//interrupt after it enables interrupts would jump back into the application it is replacing.
+static void Bootloader_StopPeripherals(void)
+{
+#ifdef UCSR0B
+	UCSR0B = 0;
+#endif
+#ifdef UCSR1B
+	UCSR1B = 0;
+#endif
+#ifdef SPCR
+	SPCR = 0;
+#endif
+#ifdef TWCR
+	TWCR = 0;
+#endif
+#ifdef ADCSRA
+	ADCSRA = 0;
+#endif
+#ifdef ACSR
+	ACSR &= ~(1<<ACIE);
+#endif
+#ifdef EECR
+	EECR &= ~(1<<EERIE);
+#endif
+#ifdef SPMCSR
+	SPMCSR &= ~(1<<SPMIE);
+#endif
+#ifdef EIMSK
+	EIMSK = 0;
+#endif
+#ifdef PCICR
+	PCICR = 0;
+#endif
+
+	//Stop the timers and turn off their interrupts
+#ifdef TIMSK0
+	TIMSK0 = 0;
+	TCCR0B = 0;
+#endif
+#ifdef TIMSK1
+	TIMSK1 = 0;
+	TCCR1B = 0;
+#endif
+#ifdef TIMSK3
+	TIMSK3 = 0;
+	TCCR3B = 0;
+#endif
+#ifdef TIMSK4
+	TIMSK4 = 0;
+	TCCR4B = 0;
+#endif
+}
+#endif
+
 void Bootloader_Jump_Check(void)
 {
 	// If the reset source was the bootloader and the key is correct, clear it and jump to the bootloader
 	if ((MCUSR & (1<<WDRF)) && (Boot_Key == MAGIC_BOOT_KEY))
 	{
 		Boot_Key = 0;
-		((void (*)(void))BOOTLOADER_START_ADDRESS)(); 
+		Bootloader_Start();
 	}
 }
 
 void Jump_To_Bootloader(void)
 {
+	// The host only needs time to see the detach if it has enumerated the device. A suspended device
+	// may or may not have been enumerated before, the address register tells which.
+	uint8_t Enumerated = (USB_DeviceState == DEVICE_STATE_Addressed) || (USB_DeviceState == DEVICE_STATE_Configured) ||
+						 ((USB_DeviceState == DEVICE_STATE_Suspended) && USB_Device_IsAddressSet());
+
 	// If USB is used, detach from the bus
 	USB_Disable();
 
 	// Disable all interrupts
 	cli();
 
-	// Wait two seconds for the USB detachment to register on the host
-	for (uint8_t i = 0; i < 128; i++)
-        _delay_ms(16);
-
-	// Set the bootloader key to the magic value and force a reset
+	// Set the bootloader key to the magic value
 	Boot_Key = MAGIC_BOOT_KEY;
-	wdt_enable(WDTO_250MS);
+
+	if (Enumerated)
+	{
+		// Wait for the USB detachment to register on the host
+		for (uint16_t i = 0; i < DFU_JUMP_DETACH_MS; i++)
+			_delay_ms(1);
+	}
+	#if DFU_JUMP_DIRECT == 1
+	else
+	{
+		// The host never saw the device, so there is nothing to wait for. Skip the reset and jump now.
+		// The key is cleared the same way Bootloader_Jump_Check() does it.
+		MCUSR &= ~(1<<WDRF);
+		wdt_disable();
+		Bootloader_StopPeripherals();
+		Boot_Key = 0;
+		Bootloader_Start();
+	}
+	#endif
+
+	// Force a reset with the shortest watchdog timeout
+	wdt_enable(WDTO_15MS);
 	for (;;); 
 }
 
@@ -32,20 +32,44 @@
 #include <util/delay.h>
 
 #include <LUFA-120730/Drivers/USB/USB.h>
+#include "config.h"
+
+/*These settings can be defined in your user code to change the bootloader jump
+ * #define DFU_JUMP_DETACH_MS		2000		//Time in ms to wait after detaching from USB so the host sees the device go away
+ * #define DFU_JUMP_DIRECT			0			//Set to 1 to jump straight to the bootloader without a reset if USB was never enumerated.
+ *													//The interrupt enables of the on-chip peripherals are cleared and the timers stopped first,
+ *													//but anything else the application set up is left as it is.
+ * #define BOOTLOADER_START_ADDRESS	0x7000		//Byte address of the bootloader. If this is not defined, the address is read from the BOOTSZ fuses at runtime.
+ */
+
+#ifndef DFU_JUMP_DETACH_MS
+	#define DFU_JUMP_DETACH_MS		2000
+#endif
+
+#ifndef DFU_JUMP_DIRECT
+	#define DFU_JUMP_DIRECT			0
+#endif
 
 #define MAGIC_BOOT_KEY            0xDC42ACCA
 
-#if (MCU==atmega32u4)||(MCU==atmega32u2)
-	#define BOOTLOADER_START_ADDRESS  (32768 - 4096)
-#elif (MCU==atmega16u4)||(MCU==atmega16u2)
-	#define BOOTLOADER_START_ADDRESS  (16384 - 4096)	//untested
-#else
-	#error: Bootloader start address not defined
+//The smallest boot section in bytes (BOOTSZ = 11). Each step down in BOOTSZ doubles it.
+#ifndef BOOTLOADER_START_ADDRESS
+	#if defined (__AVR_AT90USB646__) || defined (__AVR_AT90USB647__) || defined (__AVR_AT90USB1286__) || defined (__AVR_AT90USB1287__)
+		#define BOOTLOADER_MIN_SIZE		1024
+	#elif defined (__AVR_ATmega8U2__) || defined (__AVR_ATmega16U2__) || defined (__AVR_ATmega32U2__) || \
+		  defined (__AVR_ATmega16U4__) || defined (__AVR_ATmega32U4__) || defined (__AVR_AT90USB82__) || defined (__AVR_AT90USB162__)
+		#define BOOTLOADER_MIN_SIZE		512
+	#else
+		#error: Bootloader size not known for this part, define BOOTLOADER_START_ADDRESS
+	#endif
 #endif
 
 void Bootloader_Jump_Check(void) ATTR_INIT_SECTION(3);
 void Jump_To_Bootloader(void);
 
+/** Returns the byte address of the bootloader. Unless BOOTLOADER_START_ADDRESS is defined, this is worked out from the BOOTSZ fuses. */
+uint32_t BootloaderStartAddress(void);
+
 #endif
 
 /** @} */
\ No newline at end of file
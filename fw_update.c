@@ -0,0 +1,337 @@
+/*   This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+*	\brief		In-application firmware update
+*	\author		Pat Satyshur
+*	\version	1.0
+*	\date		3/23/2013
+*	\copyright	Copyright 2013, Pat Satyshur
+*	\ingroup 	hardware
+*
+*	The update record in EEPROM is three words: a magic value, the image length and the image CRC. The magic value is written last.
+*
+*	@{
+*/
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <avr/eeprom.h>
+#include <avr/wdt.h>
+#include <util/crc16.h>
+#include <string.h>
+#include "fw_update.h"
+#include "dfu_jump.h"
+
+//Symbols for fw_update.ld to check the .fwupdate section against
+#define FW_UPDATE_STR(x)					#x
+#define FW_UPDATE_XSTR(x)					FW_UPDATE_STR(x)
+__asm__ (
+	".global __fw_update_copier_start\n"
+	".set __fw_update_copier_start, " FW_UPDATE_XSTR(FW_UPDATE_COPIER_ADDR) "\n"
+	".global __fw_update_copier_end\n"
+	".set __fw_update_copier_end, " FW_UPDATE_XSTR(FW_UPDATE_SLOT_SIZE) "\n"
+);
+
+//The LUFA bootloader API table is at the end of flash
+#define BOOTLOADER_API_TABLE_SIZE			32
+#define BOOTLOADER_API_TABLE_START			((FLASHEND + 1UL) - BOOTLOADER_API_TABLE_SIZE)
+#define BOOTLOADER_API_CALL(Index)			((uint16_t)((BOOTLOADER_API_TABLE_START + ((Index) * 2)) / 2))
+#define BOOTLOADER_MAGIC_SIGNATURE_START	(BOOTLOADER_API_TABLE_START + (BOOTLOADER_API_TABLE_SIZE - 2))
+#define BOOTLOADER_MAGIC_SIGNATURE			0xDCFB
+
+#define BootloaderAPI_ErasePage				((void (*) (uint32_t Address))BOOTLOADER_API_CALL(0))
+#define BootloaderAPI_WritePage				((void (*) (uint32_t Address))BOOTLOADER_API_CALL(1))
+#define BootloaderAPI_FillWord				((void (*) (uint32_t Address, uint16_t Word))BOOTLOADER_API_CALL(2))
+
+#if FLASHEND > 0xFFFF
+	#define FW_UPDATE_READ_BYTE(addr)		pgm_read_byte_far(addr)
+	#define FW_UPDATE_READ_WORD(addr)		pgm_read_word_far(addr)
+#else
+	#define FW_UPDATE_READ_BYTE(addr)		pgm_read_byte((uint16_t)(addr))
+	#define FW_UPDATE_READ_WORD(addr)		pgm_read_word((uint16_t)(addr))
+#endif
+
+//Update record in EEPROM
+#define FW_UPDATE_MAGIC						0xA55A
+#define FW_UPDATE_EEPROM_MAGIC				((uint16_t *)(FW_UPDATE_EEPROM_ADDR))
+#define FW_UPDATE_EEPROM_LENGTH				((uint16_t *)(FW_UPDATE_EEPROM_ADDR + 2))
+#define FW_UPDATE_EEPROM_CRC				((uint16_t *)(FW_UPDATE_EEPROM_ADDR + 4))
+
+//The jmp opcode, the word address follows it
+#define AVR_JMP_OPCODE						0x940C
+
+//Code that runs while the lower slot is being replaced must be in this section
+#define FW_UPDATE_SECTION					__attribute__ ((section (".fwupdate")))
+
+//Receive state
+static uint8_t FWUpdate_Page[SPM_PAGESIZE];
+static uint16_t FWUpdate_PageFill;
+static uint16_t FWUpdate_Offset;
+static uint16_t FWUpdate_Length;
+static uint16_t FWUpdate_Crc;
+static uint8_t FWUpdate_Started = 0;
+
+static void FWUpdate_CheckRecord(void) __attribute__ ((noinline));
+static uint16_t FWUpdate_FlashCRC(uint32_t addr, uint16_t length);
+static void FWUpdate_WritePage(uint32_t addr, const uint8_t *data);
+void FWUpdate_CopyEntry(void) FW_UPDATE_SECTION __attribute__ ((used, naked, noreturn));
+static void FWUpdate_Copy(void) FW_UPDATE_SECTION __attribute__ ((used, noinline, noreturn));
+
+//---------------------------------------------------------------------------------------------
+//Startup check
+//---------------------------------------------------------------------------------------------
+void FWUpdate_Check(void)
+{
+	FWUpdate_CheckRecord();
+}
+
+static void FWUpdate_CheckRecord(void)
+{
+	uint16_t length;
+	uint16_t crc;
+
+	if(eeprom_read_word(FW_UPDATE_EEPROM_MAGIC) != FW_UPDATE_MAGIC)
+	{
+		return;
+	}
+
+	//The watchdog stays on after a watchdog reset, and the checks below take longer than the shortest timeout
+	MCUSR &= ~(1<<WDRF);
+	wdt_disable();
+
+	length = eeprom_read_word(FW_UPDATE_EEPROM_LENGTH);
+	crc = eeprom_read_word(FW_UPDATE_EEPROM_CRC);
+
+	if((FWUpdate_FlashCRC(0, length) != crc) && (FWUpdate_FlashCRC(FW_UPDATE_SLOT_SIZE, length) == crc))
+	{
+		FWUpdate_CopyEntry();
+	}
+
+	//The copy is done, or the staged image is bad
+	eeprom_update_word(FW_UPDATE_EEPROM_MAGIC, 0xFFFF);
+}
+
+//---------------------------------------------------------------------------------------------
+//Receiving the new image
+//---------------------------------------------------------------------------------------------
+uint8_t FWUpdate_Begin(uint16_t length, uint16_t crc)
+{
+	if(FW_UPDATE_READ_WORD(BOOTLOADER_MAGIC_SIGNATURE_START) != BOOTLOADER_MAGIC_SIGNATURE)
+	{
+		return FW_UPDATE_STAT_NO_API;
+	}
+
+	if((length == 0) || (length > FW_UPDATE_SLOT_SIZE))
+	{
+		return FW_UPDATE_STAT_TOO_BIG;
+	}
+
+	//The fuses can give a bigger boot section than BOOTLOADER_START_ADDRESS says
+	if((2UL * FW_UPDATE_SLOT_SIZE) > BootloaderStartAddress())
+	{
+		return FW_UPDATE_STAT_BOOT_OVERLAP;
+	}
+
+	//If .fwupdate ended up in .text the copy would erase itself. Function pointers are word addresses.
+	if((((uint32_t)(uint16_t)FWUpdate_CopyEntry * 2) < FW_UPDATE_COPIER_ADDR) || (((uint32_t)(uint16_t)FWUpdate_CopyEntry * 2) >= FW_UPDATE_SLOT_SIZE))
+	{
+		return FW_UPDATE_STAT_BAD_LINK;
+	}
+
+	//Disarm an update that was staged before
+	eeprom_update_word(FW_UPDATE_EEPROM_MAGIC, 0xFFFF);
+
+	FWUpdate_Length = length;
+	FWUpdate_Crc = crc;
+	FWUpdate_Offset = 0;
+	FWUpdate_PageFill = 0;
+	FWUpdate_Started = 1;
+	return FW_UPDATE_STAT_OK;
+}
+
+uint8_t FWUpdate_Write(const uint8_t *data, uint16_t len)
+{
+	if(FWUpdate_Started == 0)
+	{
+		return FW_UPDATE_STAT_NOT_STARTED;
+	}
+
+	if(len > (FWUpdate_Length - FWUpdate_Offset))
+	{
+		return FW_UPDATE_STAT_TOO_BIG;
+	}
+
+	while(len > 0)
+	{
+		FWUpdate_Page[FWUpdate_PageFill++] = *data++;
+		FWUpdate_Offset++;
+		len--;
+
+		if(FWUpdate_PageFill == SPM_PAGESIZE)
+		{
+			FWUpdate_WritePage((uint32_t)FW_UPDATE_SLOT_SIZE + FWUpdate_Offset - SPM_PAGESIZE, FWUpdate_Page);
+			FWUpdate_PageFill = 0;
+		}
+	}
+	return FW_UPDATE_STAT_OK;
+}
+
+uint8_t FWUpdate_Finish(void)
+{
+	uint16_t addr;
+
+	if(FWUpdate_Started == 0)
+	{
+		return FW_UPDATE_STAT_NOT_STARTED;
+	}
+
+	if(FWUpdate_Offset != FWUpdate_Length)
+	{
+		return FW_UPDATE_STAT_INCOMPLETE;
+	}
+	FWUpdate_Started = 0;
+
+	//Pad the last page with erased flash
+	if(FWUpdate_PageFill > 0)
+	{
+		memset(&FWUpdate_Page[FWUpdate_PageFill], 0xFF, SPM_PAGESIZE - FWUpdate_PageFill);
+		FWUpdate_WritePage((uint32_t)FW_UPDATE_SLOT_SIZE + FWUpdate_Offset - FWUpdate_PageFill, FWUpdate_Page);
+		FWUpdate_PageFill = 0;
+	}
+
+	//Check what was actually written to flash, not what was received
+	if(FWUpdate_FlashCRC(FW_UPDATE_SLOT_SIZE, FWUpdate_Length) != FWUpdate_Crc)
+	{
+		return FW_UPDATE_STAT_BAD_CRC;
+	}
+
+	//The copy routine is not replaced, so it must be the same in the new image
+	for(addr = FW_UPDATE_COPIER_ADDR; addr < FWUpdate_Length; addr++)
+	{
+		if(FW_UPDATE_READ_BYTE(addr) != FW_UPDATE_READ_BYTE((uint32_t)FW_UPDATE_SLOT_SIZE + addr))
+		{
+			return FW_UPDATE_STAT_BAD_COPIER;
+		}
+	}
+
+	eeprom_update_word(FW_UPDATE_EEPROM_LENGTH, FWUpdate_Length);
+	eeprom_update_word(FW_UPDATE_EEPROM_CRC, FWUpdate_Crc);
+	eeprom_update_word(FW_UPDATE_EEPROM_MAGIC, FW_UPDATE_MAGIC);
+	return FW_UPDATE_STAT_OK;
+}
+
+void FWUpdate_Reboot(void)
+{
+	cli();
+	wdt_enable(WDTO_15MS);
+	for(;;);
+}
+
+static uint16_t FWUpdate_FlashCRC(uint32_t addr, uint16_t length)
+{
+	uint16_t crc = 0xFFFF;
+
+	while(length > 0)
+	{
+		crc = _crc_ccitt_update(crc, FW_UPDATE_READ_BYTE(addr));
+		addr++;
+		length--;
+	}
+	return crc;
+}
+
+//Interrupts are off while the page is written. The vector table can not be read while the RWW section is busy.
+static void FWUpdate_WritePage(uint32_t addr, const uint8_t *data)
+{
+	uint8_t sreg = SREG;
+	uint16_t i;
+
+	cli();
+	BootloaderAPI_ErasePage(addr);
+	for(i = 0; i < SPM_PAGESIZE; i += 2)
+	{
+		BootloaderAPI_FillWord(addr + i, data[i] | (data[i + 1] << 8));
+	}
+	BootloaderAPI_WritePage(addr);
+	SREG = sreg;
+}
+
+//---------------------------------------------------------------------------------------------
+//Copy routine, in the .fwupdate section. Nothing here may call code in .text.
+//---------------------------------------------------------------------------------------------
+static inline uint8_t FWUpdate_ReadEEPROM(uint16_t addr) __attribute__ ((always_inline));
+static inline uint8_t FWUpdate_ReadEEPROM(uint16_t addr)
+{
+	while(EECR & (1<<EEPE));
+	EEAR = addr;
+	EECR |= (1<<EERE);
+	return EEDR;
+}
+
+static inline void FWUpdate_CopyPage(uint32_t addr) __attribute__ ((always_inline));
+static inline void FWUpdate_CopyPage(uint32_t addr)
+{
+	uint16_t i;
+
+	BootloaderAPI_ErasePage(addr);
+	for(i = 0; i < SPM_PAGESIZE; i += 2)
+	{
+		BootloaderAPI_FillWord(addr + i, FW_UPDATE_READ_WORD((uint32_t)FW_UPDATE_SLOT_SIZE + addr + i));
+	}
+	BootloaderAPI_WritePage(addr);
+}
+
+//This is also reached straight from the reset vector if the power was lost during a copy, so set up what the C runtime would
+void FWUpdate_CopyEntry(void)
+{
+	__asm__ volatile ("clr __zero_reg__");
+	SP = RAMEND;
+	FWUpdate_Copy();
+}
+
+static void FWUpdate_Copy(void)
+{
+	uint16_t length;
+	uint32_t addr;
+
+	cli();
+	MCUSR &= ~(1<<WDRF);
+	wdt_disable();
+
+	length = FWUpdate_ReadEEPROM((uint16_t)FW_UPDATE_EEPROM_LENGTH) | (FWUpdate_ReadEEPROM((uint16_t)FW_UPDATE_EEPROM_LENGTH + 1) << 8);
+	if(length > FW_UPDATE_COPIER_ADDR)
+	{
+		length = FW_UPDATE_COPIER_ADDR;
+	}
+
+	//Page 0 jumps back here until the copy is done. A power loss between the erase and the write leaves no reset vector (see fw_update.h).
+	BootloaderAPI_ErasePage(0);
+	BootloaderAPI_FillWord(0, AVR_JMP_OPCODE);
+	BootloaderAPI_FillWord(2, (uint16_t)FWUpdate_CopyEntry);
+	BootloaderAPI_WritePage(0);
+
+	for(addr = SPM_PAGESIZE; addr < length; addr += SPM_PAGESIZE)
+	{
+		FWUpdate_CopyPage(addr);
+	}
+	FWUpdate_CopyPage(0);
+
+	//Start the new image. FWUpdate_Check() sees that the lower slot matches the record and clears it.
+	wdt_enable(WDTO_15MS);
+	for(;;);
+}
+
+/** @} */
@@ -0,0 +1,142 @@
+/*   This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+*	\brief		In-application firmware update header file
+*	\author		Pat Satyshur
+*	\version	1.0
+*	\date		3/23/2013
+*	\copyright	Copyright 2013, Pat Satyshur
+*	\ingroup 	hardware
+*
+*	Updates the firmware without going through the DFU bootloader. The application flash is split in two slots:
+*	the running image in the lower slot, and a staging slot above it. The new image is written to the staging slot while the
+*	application keeps running, so it can come in over CDC, the command interface or any other channel.
+*	When the image is complete and its CRC is good, one reset copies it into the lower slot.
+*
+*	SPM only works from the boot section, so the flash is written with the bootloader API table of the LUFA (120219 or newer) DFU and CDC bootloaders.
+*	FWUpdate_Begin() fails if the bootloader does not have the API table, or if the two slots reach into the boot section (see BootloaderStartAddress() in dfu_jump.h,
+*	dfu_jump.c must be in the makefile).
+*
+*	AVR code can not run from any address, so the new image is copied over the running one after a reset.
+*	The copy routine is placed in the .fwupdate section, which must be linked at the top of the lower slot.
+*	fw_update.ld makes the link fail if it is not:
+*	\code
+*	LDFLAGS += -Wl,--section-start=.fwupdate=<FW_UPDATE_SLOT_SIZE - FW_UPDATE_COPIER_SIZE> fw_update.ld
+*	\endcode
+*	FWUpdate_Begin() also checks where the copy routine is, and fails instead of arming an update that would erase the code doing the copy.
+*	These pages are never overwritten, so new images must have the same copy routine at the same place. FWUpdate_Finish() checks this.
+*
+*	While copying, page 0 holds a jump to the copy routine, so a power loss during the copy restarts the copy at the next power up.
+*	The exception is the first page write of the copy: page 0 is erased and then written with the jump, which takes a few ms.
+*	If the power is lost in that time the reset vector is erased, the update does not resume, and the firmware has to be loaded again through the bootloader.
+*	Do not build with -mcall-prologues, the copy routine must not call code outside of its section.
+*
+*	@{
+*/
+
+#ifndef _FW_UPDATE_H_
+#define _FW_UPDATE_H_
+
+#include "stdint.h"
+#include "config.h"
+#include <avr/io.h>
+
+#ifndef FW_UPDATE_USER_CONFIG
+	#error: Firmware update settings not defined. See fw_update.h for details.
+#endif
+
+/*These setting must be defined in your user code to use the firmware update module
+ * #define FW_UPDATE_USER_CONFIG						//Define this in your user code to disable the above error.
+ * #define FW_UPDATE_SLOT_SIZE			0x3800			//Size of each slot in bytes, a multiple of SPM_PAGESIZE. Two slots must fit below the bootloader.
+ *														//This and FW_UPDATE_COPIER_SIZE are also used by the assembler, so write them without a UL suffix.
+ * #define BOOTLOADER_START_ADDRESS		0x7000			//Byte address of the bootloader (the same setting as in dfu_jump.h), needed to check the slots at compile time
+ * #define FW_UPDATE_COPIER_SIZE		512				//Space for the .fwupdate section at the top of the lower slot, a multiple of SPM_PAGESIZE
+ * #define FW_UPDATE_EEPROM_ADDR		(E2END - 5)		//Where the 6 byte update record is kept in EEPROM
+ */
+
+#ifndef FW_UPDATE_SLOT_SIZE
+	#error: FW_UPDATE_SLOT_SIZE must be defined
+#endif
+
+#ifndef FW_UPDATE_COPIER_SIZE
+	#define FW_UPDATE_COPIER_SIZE		512
+#endif
+
+#ifndef FW_UPDATE_EEPROM_ADDR
+	#define FW_UPDATE_EEPROM_ADDR		(E2END - 5)
+#endif
+
+#if ((FW_UPDATE_SLOT_SIZE % SPM_PAGESIZE) != 0) || ((FW_UPDATE_COPIER_SIZE % SPM_PAGESIZE) != 0)
+	#error: FW_UPDATE_SLOT_SIZE and FW_UPDATE_COPIER_SIZE must be multiples of SPM_PAGESIZE
+#endif
+
+#ifndef BOOTLOADER_START_ADDRESS
+	#error: BOOTLOADER_START_ADDRESS must be defined, the slots must not reach into the boot section
+#endif
+
+#if (FW_UPDATE_SLOT_SIZE * 2) > BOOTLOADER_START_ADDRESS
+	#error: FW_UPDATE_SLOT_SIZE is too big for two slots below the bootloader
+#endif
+
+//Start of the copy routine
+#define FW_UPDATE_COPIER_ADDR			(FW_UPDATE_SLOT_SIZE - FW_UPDATE_COPIER_SIZE)
+
+//Status codes
+#define FW_UPDATE_STAT_OK				0x00
+#define FW_UPDATE_STAT_NO_API			0x01	//The bootloader does not have the LUFA API table
+#define FW_UPDATE_STAT_TOO_BIG			0x02	//The image does not fit in a slot
+#define FW_UPDATE_STAT_NOT_STARTED		0x03	//FWUpdate_Begin() was not called
+#define FW_UPDATE_STAT_BAD_CRC			0x04	//The staged image does not match the CRC
+#define FW_UPDATE_STAT_BAD_COPIER		0x05	//The new image has a different copy routine
+#define FW_UPDATE_STAT_INCOMPLETE		0x06	//FWUpdate_Finish() was called before the whole image was written
+#define FW_UPDATE_STAT_BOOT_OVERLAP		0x07	//The staging slot reaches into the boot section
+#define FW_UPDATE_STAT_BAD_LINK			0x08	//The .fwupdate section is not linked at FW_UPDATE_COPIER_ADDR
+
+/** Check for an update that has been staged and copy it into place. This runs from .init3, before main().
+*	If the copy is already done, the update record is cleared.
+*/
+void FWUpdate_Check(void) __attribute__ ((used, naked, section (".init3")));
+
+/** Start receiving a new image.
+*	\param[in] length The size of the image in bytes.
+*	\param[in] crc The CRC-16-CCITT of the image (_crc_ccitt_update(), starting at 0xFFFF).
+*
+*	\return One of the FW_UPDATE_STAT_* codes
+*/
+uint8_t FWUpdate_Begin(uint16_t length, uint16_t crc);
+
+/** Add the next block of the image. The data can come in blocks of any size.
+*	Interrupts are turned off while a flash page is written (a few ms).
+*	\param[in] *data The image data.
+*	\param[in] len The number of bytes.
+*
+*	\return One of the FW_UPDATE_STAT_* codes
+*/
+uint8_t FWUpdate_Write(const uint8_t *data, uint16_t len);
+
+/** Write the last partial page, check the staged image and mark it to be copied at the next reset.
+*
+*	\return One of the FW_UPDATE_STAT_* codes. The update is only armed if this returns FW_UPDATE_STAT_OK.
+*/
+uint8_t FWUpdate_Finish(void);
+
+/** Reset the CPU with the watchdog, so an armed update is copied into place. This does not return.
+*	If USB is in use, detach from the bus first so the host sees the device go away.
+*/
+void FWUpdate_Reboot(void);
+
+#endif
+
+/** @} */
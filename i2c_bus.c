@@ -0,0 +1,164 @@
+/*   This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+*	\brief		Common I2C bus interface
+*	\author		Pat Satyshur
+*	\version	1.0
+*	\date		3/2/2013
+*	\copyright	Copyright 2013, Pat Satyshur
+*	\ingroup 	interface
+*
+*	Wraps twi.c, i2c_soft.c and the LUFA TWI driver behind the I2CBus interface and converts their status codes to the I2C_STAT_* codes.
+*
+*	@{
+*/
+
+#include <avr/io.h>
+#include "i2c_bus.h"
+
+#if I2C_BUS_USE_TWI == 1
+	#include "twi.h"
+#endif
+
+#if I2C_BUS_USE_LUFA == 1
+	#include <LUFA-120730/Drivers/Peripheral/TWI.h>
+#endif
+
+#if I2C_BUS_USE_SOFT == 1
+	#include "i2c_soft.h"
+#endif
+
+//---------------------------------------------------------------------------------------------
+//Hardware TWI backend (twi.c)
+//---------------------------------------------------------------------------------------------
+#if I2C_BUS_USE_TWI == 1
+static uint8_t I2CBus_TWI_RW(I2CTransaction *Transaction)
+{
+	uint8_t stat;
+
+	stat = TWIRW(Transaction->sla, Transaction->SendData, Transaction->RecieveData, Transaction->BytesToSend, Transaction->BytesToRecieve);
+
+	//TWIRW returns 0xFF on a timeout, otherwise the raw TWSR (including the prescaler bits)
+	if((stat == 0x00) || (stat == 0xFF))
+	{
+		return stat;
+	}
+	return (stat & TWI_STATUS_MASK);
+}
+
+const I2CBus I2CBus_TWI = { InitTWI, I2CBus_TWI_RW };
+#endif
+
+//---------------------------------------------------------------------------------------------
+//LUFA TWI backend (TWI_AVR8.c)
+//---------------------------------------------------------------------------------------------
+#if I2C_BUS_USE_LUFA == 1
+static void I2CBus_LUFA_Init(void)
+{
+	TWI_Init(TWI_BIT_PRESCALE_1, TWI_BITLENGTH_FROM_FREQ(1, I2C_BUS_LUFA_SCL_FREQ_HZ));
+}
+
+static uint8_t I2CBus_LUFA_RW(I2CTransaction *Transaction)
+{
+	uint8_t stat;
+
+	if(Transaction->BytesToRecieve > 0)
+	{
+		//The data to send is treated as the internal address, LUFA sends it and then does a repeated start
+		stat = TWI_ReadPacket(Transaction->sla << 1, I2C_BUS_LUFA_TIMEOUT_MS, Transaction->SendData, Transaction->BytesToSend,
+							  Transaction->RecieveData, Transaction->BytesToRecieve);
+	}
+	else
+	{
+		stat = TWI_WritePacket(Transaction->sla << 1, I2C_BUS_LUFA_TIMEOUT_MS, Transaction->SendData, 0,
+							   Transaction->SendData, Transaction->BytesToSend);
+	}
+
+	switch(stat)
+	{
+		case TWI_ERROR_NoError:
+			return I2C_STAT_OK;
+
+		case TWI_ERROR_BusFault:
+			return I2C_STAT_BUS_ERROR;
+
+		case TWI_ERROR_SlaveNotReady:
+			return I2C_STAT_SLAW_NOACK;
+
+		case TWI_ERROR_SlaveNAK:
+			return I2C_STAT_DATA_TX_NOACK;
+
+		case TWI_ERROR_BusCaptureTimeout:
+		case TWI_ERROR_SlaveResponseTimeout:
+		default:
+			return I2C_STAT_TIMEOUT;
+	}
+}
+
+const I2CBus I2CBus_LUFA = { I2CBus_LUFA_Init, I2CBus_LUFA_RW };
+#endif
+
+//---------------------------------------------------------------------------------------------
+//Software I2C backend (i2c_soft.c)
+//---------------------------------------------------------------------------------------------
+#if I2C_BUS_USE_SOFT == 1
+static uint8_t I2CBus_Soft_RW(I2CTransaction *Transaction)
+{
+	//The software status codes are already the same as the I2C_STAT_* codes
+	return I2CSoft_RW(Transaction->sla, Transaction->SendData, Transaction->RecieveData, Transaction->BytesToSend, Transaction->BytesToRecieve);
+}
+
+const I2CBus I2CBus_Soft = { I2CSoft_Init, I2CBus_Soft_RW };
+#endif
+
+//---------------------------------------------------------------------------------------------
+//Common helpers
+//---------------------------------------------------------------------------------------------
+uint8_t I2CBus_ReadRegs(const I2CBus *Bus, uint8_t sla, uint8_t Reg, uint8_t *Data, uint8_t Length)
+{
+	I2CTransaction Transaction;
+
+	if(Length == 0)
+	{
+		return I2C_STAT_PARAMETER_ERROR;
+	}
+
+	Transaction.sla = sla;
+	Transaction.SendData = &Reg;
+	Transaction.RecieveData = Data;
+	Transaction.BytesToSend = 1;
+	Transaction.BytesToRecieve = Length;
+
+	return Bus->RW(&Transaction);
+}
+
+uint8_t I2CBus_WriteReg(const I2CBus *Bus, uint8_t sla, uint8_t Reg, uint8_t Value)
+{
+	I2CTransaction Transaction;
+	uint8_t SendData[2];
+
+	SendData[0] = Reg;
+	SendData[1] = Value;
+
+	Transaction.sla = sla;
+	Transaction.SendData = SendData;
+	Transaction.RecieveData = 0;
+	Transaction.BytesToSend = 2;
+	Transaction.BytesToRecieve = 0;
+
+	return Bus->RW(&Transaction);
+}
+
+/** @} */
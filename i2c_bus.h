@@ -0,0 +1,181 @@
+/*   This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+*	\brief		Common I2C bus interface header
+*	\author		Pat Satyshur
+*	\version	1.0
+*	\date		3/2/2013
+*	\copyright	Copyright 2013, Pat Satyshur
+*	\ingroup 	interface
+*
+*	Device drivers should talk to an I2CBus instead of calling TWIRW(), I2CSoft_RW() or the LUFA TWI functions directly.
+*	The same driver can then run on whichever backend the board has. All backends return the I2C_STAT_* codes below.
+*
+*	@{
+*/
+
+//Note: the slave address in the transaction should only be the 7-bit address, just like TWIRW() and I2CSoft_RW().
+
+#ifndef _I2C_BUS_H_
+#define _I2C_BUS_H_
+
+#include "stdint.h"
+#include "config.h"
+
+#ifndef I2C_BUS_USER_CONFIG
+	#error: I2C bus settings not defined. See i2c_bus.h for details.
+#endif
+
+/*These setting must be defined in your user code to use the I2C bus module
+ * #define I2C_BUS_USER_CONFIG					//Define this in your user code to disable the above error.
+ * #define I2C_BUS_USE_TWI				1		//Set to 1 to build the hardware TWI backend (twi.c must be in the makefile)
+ * #define I2C_BUS_USE_LUFA				0		//Set to 1 to build the LUFA TWI backend (TWI_AVR8.c must be in the makefile)
+ * #define I2C_BUS_USE_SOFT				0		//Set to 1 to build the software I2C backend (i2c_soft.c must be in the makefile)
+ * #define I2C_BUS_LUFA_TIMEOUT_MS		10		//Bus capture timeout for the LUFA backend in ms
+ * #define I2C_BUS_LUFA_SCL_FREQ_HZ		100000	//The SCL frequency in Hz for the LUFA backend
+ */
+
+#ifndef I2C_BUS_USE_TWI
+	#define I2C_BUS_USE_TWI				0
+#endif
+
+#ifndef I2C_BUS_USE_LUFA
+	#define I2C_BUS_USE_LUFA			0
+#endif
+
+#ifndef I2C_BUS_USE_SOFT
+	#define I2C_BUS_USE_SOFT			0
+#endif
+
+#if (I2C_BUS_USE_TWI == 1) && (I2C_BUS_USE_LUFA == 1)
+	#error: The TWI and LUFA backends both use the TWI hardware, only enable one of them
+#endif
+
+#if (I2C_BUS_USE_TWI == 0) && (I2C_BUS_USE_LUFA == 0) && (I2C_BUS_USE_SOFT == 0)
+	#error: No I2C bus backend enabled
+#endif
+
+#ifndef I2C_BUS_LUFA_TIMEOUT_MS
+	#define I2C_BUS_LUFA_TIMEOUT_MS		10
+#endif
+
+#ifndef I2C_BUS_LUFA_SCL_FREQ_HZ
+	#define I2C_BUS_LUFA_SCL_FREQ_HZ	100000
+#endif
+
+//Status codes common to all backends
+//These use the same values as the AVR8 TWI status codes, except that 0x00 means all is well
+#define I2C_STAT_OK					0x00
+#define I2C_STAT_SLAW_NOACK			0x20
+#define I2C_STAT_DATA_TX_NOACK		0x30
+#define I2C_STAT_ARB_LOST			0x38
+#define I2C_STAT_SLAR_NOACK			0x48
+#define I2C_STAT_PARAMETER_ERROR	0xAE
+#define I2C_STAT_BUS_ERROR			0xAF
+#define I2C_STAT_TIMEOUT			0xFF
+
+/** A single I2C transfer. BytesToSend bytes are written to the device, then BytesToRecieve bytes are read back after a repeated start. */
+typedef struct I2CTransaction
+{
+	/**The 7-bit slave address*/
+	uint8_t sla;
+
+	/**The data to write to the device*/
+	uint8_t *SendData;
+
+	/**Where to put the data read from the device*/
+	uint8_t *RecieveData;
+
+	/**The number of bytes to write*/
+	uint8_t BytesToSend;
+
+	/**The number of bytes to read*/
+	uint8_t BytesToRecieve;
+} I2CTransaction;
+
+/** A bus backend. Drivers should hold a pointer to one of these and not care which backend it is. */
+typedef struct I2CBus
+{
+	/**Initializes the backend hardware or pins*/
+	void (*Init) (void);
+
+	/**Runs a transaction, returns one of the I2C_STAT_* codes*/
+	uint8_t (*RW) (I2CTransaction *Transaction);
+} I2CBus;
+
+#if I2C_BUS_USE_TWI == 1
+extern const I2CBus I2CBus_TWI;
+#endif
+
+#if I2C_BUS_USE_LUFA == 1
+extern const I2CBus I2CBus_LUFA;
+#endif
+
+#if I2C_BUS_USE_SOFT == 1
+extern const I2CBus I2CBus_Soft;
+#endif
+
+//The fastest backend that was built. Drivers that do not need a specific bus can bind to this.
+#if I2C_BUS_USE_TWI == 1
+	#define I2C_BUS_DEFAULT		(&I2CBus_TWI)
+#elif I2C_BUS_USE_LUFA == 1
+	#define I2C_BUS_DEFAULT		(&I2CBus_LUFA)
+#else
+	#define I2C_BUS_DEFAULT		(&I2CBus_Soft)
+#endif
+
+/** Initialize an I2C bus
+*	\param[in] Bus The bus to initialize.
+*/
+static inline void I2CBus_Init(const I2CBus *Bus)
+{
+	Bus->Init();
+}
+
+/** Run a transaction on an I2C bus
+*	\param[in] Bus The bus to use.
+*	\param[in] Transaction The transaction to run.
+*
+*	\return The I2C status (I2C_STAT_OK for OK)
+*/
+static inline uint8_t I2CBus_RW(const I2CBus *Bus, I2CTransaction *Transaction)
+{
+	return Bus->RW(Transaction);
+}
+
+/** Read a block of registers from a device. This is the usual 'write register address, repeated start, read' sequence used by most sensors.
+*	\param[in] Bus The bus to use.
+*	\param[in] sla The 7-bit slave address of the I2C device.
+*	\param[in] Reg The first register to read.
+*	\param[out] *Data Where to put the register data.
+*	\param[in] Length The number of registers to read.
+*
+*	\return The I2C status (I2C_STAT_OK for OK)
+*/
+uint8_t I2CBus_ReadRegs(const I2CBus *Bus, uint8_t sla, uint8_t Reg, uint8_t *Data, uint8_t Length);
+
+/** Write a single register on a device.
+*	\param[in] Bus The bus to use.
+*	\param[in] sla The 7-bit slave address of the I2C device.
+*	\param[in] Reg The register to write.
+*	\param[in] Value The value to write.
+*
+*	\return The I2C status (I2C_STAT_OK for OK)
+*/
+uint8_t I2CBus_WriteReg(const I2CBus *Bus, uint8_t sla, uint8_t Reg, uint8_t Value);
+
+#endif
+
+/** @} */
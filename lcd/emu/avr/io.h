@@ -0,0 +1,59 @@
+/*   This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+*	\brief		Host replacement for avr/io.h, used with the HD44780 emulator
+*	\author		Pat Satyshur
+*	\version	1.0
+*	\date		4/20/2013
+*	\copyright	Copyright 2013, Pat Satyshur
+*	\ingroup 	interface
+*
+*	Only the port registers are here. Each port is {PIN, DDR, PORT} in hd44780_emu_ports[], the same order as on the AVR,
+*	so the DDR() and PIN() macros in lcd.c find the right registers.
+*
+*	@{
+*/
+
+#ifndef _HD44780_EMU_AVR_IO_H_
+#define _HD44780_EMU_AVR_IO_H_
+
+#include <inttypes.h>
+
+extern uint8_t hd44780_emu_ports[6][3];
+
+#define PINA		(hd44780_emu_ports[0][0])
+#define DDRA		(hd44780_emu_ports[0][1])
+#define PORTA		(hd44780_emu_ports[0][2])
+#define PINB		(hd44780_emu_ports[1][0])
+#define DDRB		(hd44780_emu_ports[1][1])
+#define PORTB		(hd44780_emu_ports[1][2])
+#define PINC		(hd44780_emu_ports[2][0])
+#define DDRC		(hd44780_emu_ports[2][1])
+#define PORTC		(hd44780_emu_ports[2][2])
+#define PIND		(hd44780_emu_ports[3][0])
+#define DDRD		(hd44780_emu_ports[3][1])
+#define PORTD		(hd44780_emu_ports[3][2])
+#define PINE		(hd44780_emu_ports[4][0])
+#define DDRE		(hd44780_emu_ports[4][1])
+#define PORTE		(hd44780_emu_ports[4][2])
+#define PINF		(hd44780_emu_ports[5][0])
+#define DDRF		(hd44780_emu_ports[5][1])
+#define PORTF		(hd44780_emu_ports[5][2])
+
+#define _BV(bit)	(1 << (bit))
+
+#endif
+
+/** @} */
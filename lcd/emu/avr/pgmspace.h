@@ -0,0 +1,41 @@
+/*   This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+*	\brief		Host replacement for avr/pgmspace.h, used with the HD44780 emulator
+*	\author		Pat Satyshur
+*	\version	1.0
+*	\date		4/20/2013
+*	\copyright	Copyright 2013, Pat Satyshur
+*	\ingroup 	interface
+*
+*	On the host program memory is ordinary memory.
+*
+*	@{
+*/
+
+#ifndef _HD44780_EMU_AVR_PGMSPACE_H_
+#define _HD44780_EMU_AVR_PGMSPACE_H_
+
+#include <inttypes.h>
+
+#define PROGMEM
+#define PSTR(s)						(s)
+#define pgm_read_byte(addr)			(*(const uint8_t *)(addr))
+#define pgm_read_byte_near(addr)	pgm_read_byte(addr)
+#define pgm_read_word(addr)			(*(const uint16_t *)(addr))
+
+#endif
+
+/** @} */
@@ -0,0 +1,497 @@
+/*   This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+*	\brief		HD44780 emulator for host builds of lcd.c
+*	\author		Pat Satyshur
+*	\version	1.0
+*	\date		4/20/2013
+*	\copyright	Copyright 2013, Pat Satyshur
+*	\ingroup 	interface
+*
+*	Instruction times are from the HD44780U data sheet at 270kHz: 37us for most instructions and data writes, 1.52ms for
+*	clear display and return home. After power up the first function set takes 4.1ms and the second 100us, so the
+*	initialization by instruction is checked too. The 4us address counter update after a data write is not modelled.
+*
+*	@{
+*/
+
+#include <stdio.h>
+#include <avr/io.h>
+#include "hd44780_emu.h"
+
+//Instruction times in ns at 270kHz
+#define HD44780_EMU_EXEC_NS				37000UL
+#define HD44780_EMU_CLEAR_NS			1520000UL
+#define HD44780_EMU_POWER_UP_NS			15000000UL
+#define HD44780_EMU_INIT1_NS			4100000UL
+#define HD44780_EMU_INIT2_NS			100000UL
+
+//The registers of PORTA to PORTF, as {PIN, DDR, PORT} so the DDR() and PIN() macros in lcd.c work
+uint8_t hd44780_emu_ports[6][3];
+
+static struct
+{
+	uint8_t Lines;
+	uint8_t Columns;
+	uint8_t LineStart[4];
+	uint16_t FoscKHz;
+	uint8_t Controller;
+
+	uint8_t DDRAM[HD44780_EMU_DDRAM_SIZE];
+	uint8_t CGRAM[HD44780_EMU_CGRAM_SIZE];
+	uint8_t Address;
+	uint8_t InCGRAM;		//The address counter points into CGRAM
+
+	uint8_t Increment;		//Entry mode I/D
+	uint8_t ShiftOnWrite;	//Entry mode S
+	uint8_t DisplayOn;
+	int16_t Shift;			//Display shift, in characters to the left
+
+	uint8_t Bus8Bit;		//Function set DL
+	uint8_t TwoLines;		//Function set N
+	uint8_t ExtRegister;	//KS0073 function set RE
+	uint8_t FourLines;		//KS0073 extended function set NW
+	uint8_t InitCount;		//Function sets since power up, for the init timing
+
+	uint8_t Nibble;			//1 when the high nibble of a byte has been sent on the 4 bit bus
+	uint8_t HighNibble;
+	uint8_t ReadByte;		//Byte being read on the 4 bit bus
+	uint8_t E;
+
+	uint64_t Now;
+	uint64_t BusyUntil;
+	HD44780EmuStats Stats;
+} emu;
+
+//Scale a time at 270kHz to the controller clock
+static uint64_t hd44780_emu_exec_time(uint64_t ns)
+{
+	return (ns * 270 + emu.FoscKHz - 1) / emu.FoscKHz;
+}
+
+//Length and DDRAM start of the memory line an address is in
+static void hd44780_emu_mem_line(uint8_t addr, uint8_t *base, uint8_t *len)
+{
+	if(emu.FourLines)
+	{
+		*base = addr & 0x60;
+		*len = 0x14;
+	}
+	else if(emu.TwoLines)
+	{
+		*base = addr & 0x40;
+		*len = 0x28;
+	}
+	else
+	{
+		*base = 0x00;
+		*len = 0x50;
+	}
+}
+
+//Move the DDRAM address counter by one, going from the end of one memory line to the start of the next
+static uint8_t hd44780_emu_step_ddram(uint8_t addr, uint8_t increment)
+{
+	uint8_t base;
+	uint8_t len;
+	uint8_t lines;
+
+	hd44780_emu_mem_line(addr, &base, &len);
+	lines = emu.FourLines ? 4 : (emu.TwoLines ? 2 : 1);
+
+	if(increment)
+	{
+		if(addr - base + 1 < len)
+		{
+			return addr + 1;
+		}
+		return (lines == 1) ? 0x00 : ((base + 0x80 / lines) & 0x7F);
+	}
+
+	if(addr > base)
+	{
+		return addr - 1;
+	}
+	base = (lines == 1) ? 0x00 : ((base - 0x80 / lines) & 0x7F);
+	return base + len - 1;
+}
+
+static void hd44780_emu_step(void)
+{
+	if(emu.InCGRAM)
+	{
+		emu.Address = (emu.Address + (emu.Increment ? 1 : -1)) & (HD44780_EMU_CGRAM_SIZE - 1);
+	}
+	else
+	{
+		emu.Address = hd44780_emu_step_ddram(emu.Address, emu.Increment);
+	}
+}
+
+static void hd44780_emu_busy(uint64_t ns)
+{
+	emu.BusyUntil = emu.Now + hd44780_emu_exec_time(ns);
+}
+
+static void hd44780_emu_instruction(uint8_t cmd)
+{
+	uint8_t i;
+
+	emu.Stats.Instructions++;
+
+	if(cmd & 0x80)
+	{
+		//Set DDRAM address
+		emu.Address = cmd & 0x7F;
+		emu.InCGRAM = 0;
+	}
+	else if(cmd & 0x40)
+	{
+		//Set CGRAM address
+		emu.Address = cmd & 0x3F;
+		emu.InCGRAM = 1;
+	}
+	else if(cmd & 0x20)
+	{
+		//Function set
+		emu.Bus8Bit = (cmd & 0x10) ? 1 : 0;
+		emu.TwoLines = (cmd & 0x08) ? 1 : 0;
+		if(emu.Controller == HD44780_EMU_KS0073)
+		{
+			emu.ExtRegister = (cmd & 0x04) ? 1 : 0;
+		}
+
+		if(emu.InitCount < 2)
+		{
+			hd44780_emu_busy(emu.InitCount == 0 ? HD44780_EMU_INIT1_NS : HD44780_EMU_INIT2_NS);
+			emu.InitCount++;
+			return;
+		}
+	}
+	else if(cmd & 0x10)
+	{
+		//Cursor or display shift
+		if(cmd & 0x08)
+		{
+			emu.Shift += (cmd & 0x04) ? -1 : 1;
+		}
+		else if(!emu.InCGRAM)
+		{
+			emu.Address = hd44780_emu_step_ddram(emu.Address, (cmd & 0x04) ? 1 : 0);
+		}
+	}
+	else if(cmd & 0x08)
+	{
+		if(emu.ExtRegister)
+		{
+			//KS0073 extended function set, NW selects the 4 line mode
+			emu.FourLines = (cmd & 0x01) ? 1 : 0;
+		}
+		else
+		{
+			//Display on/off control, the cursor is not shown in the emulator
+			emu.DisplayOn = (cmd & 0x04) ? 1 : 0;
+		}
+	}
+	else if(cmd & 0x04)
+	{
+		//Entry mode set
+		emu.Increment = (cmd & 0x02) ? 1 : 0;
+		emu.ShiftOnWrite = (cmd & 0x01) ? 1 : 0;
+	}
+	else if(cmd & 0x02)
+	{
+		//Return home
+		emu.Address = 0;
+		emu.InCGRAM = 0;
+		emu.Shift = 0;
+		hd44780_emu_busy(HD44780_EMU_CLEAR_NS);
+		return;
+	}
+	else if(cmd & 0x01)
+	{
+		//Clear display
+		for(i = 0; i < HD44780_EMU_DDRAM_SIZE; i++)
+		{
+			emu.DDRAM[i] = ' ';
+		}
+		emu.Address = 0;
+		emu.InCGRAM = 0;
+		emu.Shift = 0;
+		emu.Increment = 1;
+		hd44780_emu_busy(HD44780_EMU_CLEAR_NS);
+		return;
+	}
+
+	hd44780_emu_busy(HD44780_EMU_EXEC_NS);
+}
+
+static void hd44780_emu_write(uint8_t rs, uint8_t data)
+{
+	if(emu.Now < emu.BusyUntil)
+	{
+		//Carried out anyway so the screen shows what was meant, but counted as a bug
+		emu.Stats.BusyViolations++;
+	}
+
+	if(rs == 0)
+	{
+		hd44780_emu_instruction(data);
+		return;
+	}
+
+	emu.Stats.DataWrites++;
+	if(emu.InCGRAM)
+	{
+		emu.CGRAM[emu.Address] = data & 0x1F;
+	}
+	else
+	{
+		emu.DDRAM[emu.Address] = data;
+		if(emu.ShiftOnWrite)
+		{
+			emu.Shift += emu.Increment ? 1 : -1;
+		}
+	}
+	hd44780_emu_step();
+	hd44780_emu_busy(HD44780_EMU_EXEC_NS);
+}
+
+static uint8_t hd44780_emu_read(uint8_t rs)
+{
+	uint8_t data;
+
+	if(rs == 0)
+	{
+		emu.Stats.BusyReads++;
+		return ((emu.Now < emu.BusyUntil) ? 0x80 : 0x00) | emu.Address;
+	}
+
+	emu.Stats.DataReads++;
+	if(emu.Now < emu.BusyUntil)
+	{
+		emu.Stats.BusyViolations++;
+	}
+	data = emu.InCGRAM ? emu.CGRAM[emu.Address] : emu.DDRAM[emu.Address];
+	hd44780_emu_step();
+	return data;
+}
+
+void hd44780_emu_init(uint8_t lines, uint8_t columns, uint16_t fosc_khz, uint8_t controller)
+{
+	uint8_t i;
+
+	for(i = 0; i < HD44780_EMU_DDRAM_SIZE; i++)
+	{
+		emu.DDRAM[i] = ' ';
+	}
+	for(i = 0; i < HD44780_EMU_CGRAM_SIZE; i++)
+	{
+		emu.CGRAM[i] = 0;
+	}
+
+	emu.Lines = lines;
+	emu.Columns = columns;
+	emu.FoscKHz = fosc_khz;
+	emu.Controller = controller;
+
+	//Where each visible line starts in DDRAM, the same as LCD_START_LINEx in lcd.h
+	if(controller == HD44780_EMU_KS0073)
+	{
+		emu.LineStart[0] = 0x00;
+		emu.LineStart[1] = (lines == 4) ? 0x20 : 0x40;
+		emu.LineStart[2] = 0x40;
+		emu.LineStart[3] = 0x60;
+	}
+	else
+	{
+		emu.LineStart[0] = 0x00;
+		emu.LineStart[1] = 0x40;
+		emu.LineStart[2] = columns;
+		emu.LineStart[3] = 0x40 + columns;
+	}
+
+	//Reset state of the controller
+	emu.Address = 0;
+	emu.InCGRAM = 0;
+	emu.Increment = 1;
+	emu.ShiftOnWrite = 0;
+	emu.DisplayOn = 0;
+	emu.Shift = 0;
+	emu.Bus8Bit = 1;
+	emu.TwoLines = 0;
+	emu.ExtRegister = 0;
+	emu.FourLines = 0;
+	emu.InitCount = 0;
+	emu.Nibble = 0;
+	emu.E = 0;
+
+	emu.Now = 0;
+	emu.BusyUntil = HD44780_EMU_POWER_UP_NS;
+	hd44780_emu_reset_stats();
+}
+
+uint8_t hd44780_emu_bus(uint8_t e, uint8_t rs, uint8_t rw, uint8_t data)
+{
+	uint8_t rising = (e != 0) && (emu.E == 0);
+	uint8_t falling = (e == 0) && (emu.E != 0);
+
+	emu.E = e;
+	emu.Now += HD44780_EMU_EDGE_NS;
+
+	if(rising)
+	{
+		emu.Stats.BusCycles++;
+	}
+
+	if(rw)
+	{
+		//The controller drives the bus from the rising edge, a byte is read in the first cycle
+		if(rising)
+		{
+			if(emu.Bus8Bit || (emu.Nibble == 0))
+			{
+				emu.ReadByte = hd44780_emu_read(rs);
+			}
+		}
+		if(e)
+		{
+			return (emu.Bus8Bit || (emu.Nibble == 0)) ? (emu.ReadByte >> 4) : (emu.ReadByte & 0x0F);
+		}
+		if(falling && !emu.Bus8Bit)
+		{
+			emu.Nibble ^= 1;
+		}
+		return data;
+	}
+
+	//Writes are latched on the falling edge. In 8 bit mode D0-D3 are not connected and read as 0.
+	if(falling)
+	{
+		if(emu.Bus8Bit)
+		{
+			hd44780_emu_write(rs, (data & 0x0F) << 4);
+		}
+		else if(emu.Nibble == 0)
+		{
+			emu.HighNibble = data & 0x0F;
+			emu.Nibble = 1;
+		}
+		else
+		{
+			emu.Nibble = 0;
+			hd44780_emu_write(rs, (emu.HighNibble << 4) | (data & 0x0F));
+		}
+	}
+	return data;
+}
+
+void hd44780_emu_delay_us(uint32_t us)
+{
+	emu.Now += (uint64_t)us * 1000;
+}
+
+uint8_t hd44780_emu_getc(uint8_t x, uint8_t y)
+{
+	uint8_t base;
+	uint8_t len;
+	int16_t offset;
+
+	if((emu.DisplayOn == 0) || (x >= emu.Columns) || (y >= emu.Lines))
+	{
+		return ' ';
+	}
+
+	hd44780_emu_mem_line(emu.LineStart[y], &base, &len);
+	offset = (emu.LineStart[y] - base + x + emu.Shift) % len;
+	if(offset < 0)
+	{
+		offset += len;
+	}
+	return emu.DDRAM[base + offset];
+}
+
+void hd44780_emu_line(uint8_t y, char *buf)
+{
+	uint8_t x;
+	uint8_t c;
+
+	for(x = 0; x < emu.Columns; x++)
+	{
+		c = hd44780_emu_getc(x, y);
+		if(c < 0x10)
+		{
+			c = '#';
+		}
+		else if((c < 0x20) || (c > 0x7E))
+		{
+			c = '?';
+		}
+		buf[x] = c;
+	}
+	buf[x] = 0;
+}
+
+void hd44780_emu_print(void)
+{
+	char buf[HD44780_EMU_DDRAM_SIZE + 1];
+	uint8_t x;
+	uint8_t y;
+
+	putchar('+');
+	for(x = 0; x < emu.Columns; x++)
+	{
+		putchar('-');
+	}
+	printf("+\n");
+
+	for(y = 0; y < emu.Lines; y++)
+	{
+		hd44780_emu_line(y, buf);
+		printf("|%s|\n", buf);
+	}
+
+	putchar('+');
+	for(x = 0; x < emu.Columns; x++)
+	{
+		putchar('-');
+	}
+	printf("+\n");
+}
+
+uint8_t hd44780_emu_cgram(uint8_t code, uint8_t row)
+{
+	return emu.CGRAM[((code & 0x07) << 3) | (row & 0x07)];
+}
+
+uint8_t hd44780_emu_address(void)
+{
+	return emu.Address;
+}
+
+void hd44780_emu_stats(HD44780EmuStats *stats)
+{
+	*stats = emu.Stats;
+	stats->TimeNs = emu.Now;
+}
+
+void hd44780_emu_reset_stats(void)
+{
+	HD44780EmuStats zero = {0};
+
+	emu.Stats = zero;
+}
+
+/** @} */
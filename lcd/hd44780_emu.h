@@ -0,0 +1,146 @@
+/*   This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+*	\brief		HD44780 emulator for host builds of lcd.c header file
+*	\author		Pat Satyshur
+*	\version	1.0
+*	\date		4/20/2013
+*	\copyright	Copyright 2013, Pat Satyshur
+*	\ingroup 	interface
+*
+*	Emulates one HD44780 (or KS0073) controller on the 4 bit bus, so lcd.c and the code using it can be run on a PC.
+*	DDRAM, CGRAM, the address counter, entry mode, display shift and the busy time of each instruction are modelled.
+*	The screen can be printed as text, and the bus cycles and busy violations are counted so redraw code can be compared.
+*
+*	Build lcd.c for the host with LCD_EMULATOR defined and lcd/emu in the include path. The avr/io.h and avr/pgmspace.h
+*	there replace the avr-libc ones, PORTA to PORTF are plain variables. lcd.h must use LCD_IO_MODE 1.
+*	\code
+*	gcc -DLCD_EMULATOR -Ilcd/emu -Ilcd -I<dir of lcd.h> lcd/lcd.c lcd/hd44780_emu.c main.c
+*	\endcode
+*	lcd.c sends every E edge to hd44780_emu_bus(), and delay() only moves the emulated time forward.
+*	Time spent running code between bus cycles is not counted, so the timing checks are stricter than real hardware.
+*	LCD_MULTI_DISPLAY is not supported, there is only one emulated display.
+*
+*	@{
+*/
+
+#ifndef _HD44780_EMU_H_
+#define _HD44780_EMU_H_
+
+#include <inttypes.h>
+
+/*These settings can be defined on the compiler command line
+ * #define HD44780_EMU_EDGE_NS			250		//Emulated time for each E edge, two edges are one bus cycle
+ */
+
+#ifndef HD44780_EMU_EDGE_NS
+	#define HD44780_EMU_EDGE_NS			250
+#endif
+
+//Controller types for hd44780_emu_init()
+#define HD44780_EMU_HD44780				0
+#define HD44780_EMU_KS0073				1
+
+//Size of the DDRAM address space and of CGRAM
+#define HD44780_EMU_DDRAM_SIZE			0x80
+#define HD44780_EMU_CGRAM_SIZE			0x40
+
+/** Counters since the last hd44780_emu_reset_stats() */
+typedef struct HD44780EmuStats
+{
+	/**E pulses, each one is one bus cycle (two for each byte on the 4 bit bus)*/
+	uint32_t BusCycles;
+
+	/**Instructions written*/
+	uint32_t Instructions;
+
+	/**Data bytes written*/
+	uint32_t DataWrites;
+
+	/**Busy flag reads*/
+	uint32_t BusyReads;
+
+	/**Data bytes read*/
+	uint32_t DataReads;
+
+	/**Instructions and data written while the controller was busy. A real display would lose or garble these.*/
+	uint32_t BusyViolations;
+
+	/**Emulated time in ns*/
+	uint64_t TimeNs;
+} HD44780EmuStats;
+
+/** Power up the emulated display. The controller is busy for 15ms and in 8 bit mode, like a real one.
+*	\param[in] lines Number of visible lines (1, 2 or 4).
+*	\param[in] columns Number of visible characters on each line.
+*	\param[in] fosc_khz Controller clock, the instruction times are scaled from 270kHz.
+*	\param[in] controller HD44780_EMU_HD44780 or HD44780_EMU_KS0073.
+*/
+void hd44780_emu_init(uint8_t lines, uint8_t columns, uint16_t fosc_khz, uint8_t controller);
+
+/** Called by lcd.c on each E edge.
+*	\param[in] e The level of E.
+*	\param[in] rs The level of RS.
+*	\param[in] rw The level of R/W.
+*	\param[in] data The levels on D4-D7 (bit 0 is D4).
+*
+*	\return The levels on D4-D7. While E is high in read mode the controller drives them, otherwise this is data.
+*/
+uint8_t hd44780_emu_bus(uint8_t e, uint8_t rs, uint8_t rw, uint8_t data);
+
+/** Move the emulated time forward, this is what delay() does in lcd.c
+*	\param[in] us The time in us.
+*/
+void hd44780_emu_delay_us(uint32_t us);
+
+/** Get the character code shown at a position. The display shift is included, a display that is off shows spaces.
+*	\param[in] x The column.
+*	\param[in] y The line.
+*
+*	\return The character code
+*/
+uint8_t hd44780_emu_getc(uint8_t x, uint8_t y);
+
+/** Get one line of the screen as text. Characters 0-15 (CGRAM) are shown as '#', codes that are not ASCII as '?'.
+*	\param[in] y The line.
+*	\param[out] *buf At least columns + 1 bytes, the line is NUL terminated.
+*/
+void hd44780_emu_line(uint8_t y, char *buf);
+
+/** Print the screen to stdout with a frame around it */
+void hd44780_emu_print(void);
+
+/** Get a row of a user defined character.
+*	\param[in] code The character code (0-7).
+*	\param[in] row The row (0-7).
+*
+*	\return The 5 pixels of the row
+*/
+uint8_t hd44780_emu_cgram(uint8_t code, uint8_t row);
+
+/** Get the address counter */
+uint8_t hd44780_emu_address(void);
+
+/** Get the counters.
+*	\param[out] *stats Where the counters are copied.
+*/
+void hd44780_emu_stats(HD44780EmuStats *stats);
+
+/** Clear the counters, except for the emulated time. Call this before an operation to count its bus cycles. */
+void hd44780_emu_reset_stats(void);
+
+#endif
+
+/** @} */
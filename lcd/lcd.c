@@ -18,6 +18,19 @@
        Memory mapped mode compatible with Kanda STK200, but supports also
        generation of R/W signal through A8 address line.
 
+       In IO port mode the R/W line can be tied to GND (LCD_WRITE_ONLY=1).
+       The busy flag can't be read then, so each instruction is given the
+       execution time from the data sheet, scaled to the controller clock
+       (LCD_CONTROLLER_KHZ). The address counter is kept in software.
+
+       With LCD_MULTI_DISPLAY=1 several displays share the data and RS
+       lines, each with its own E line. lcd_select() picks the display
+       the other functions work on. A group of displays with their E
+       lines on the same port is written at once, see lcd_ext.h.
+
+       With LCD_EMULATOR defined, lcd.c is built for a PC and drives the
+       HD44780 emulator in hd44780_emu.c instead of real port pins.
+
  USAGE
        See the C include lcd.h file for a description of each function
        
@@ -26,6 +39,7 @@
 #include <avr/io.h>
 #include <avr/pgmspace.h>
 #include "lcd.h"
+#include "lcd_ext.h"
 
 
 
@@ -41,13 +55,97 @@
 #endif
 
 
+/*
+** write only mode (R/W tied low), these can be set in lcd.h
+*/
+#ifndef LCD_WRITE_ONLY
+#define LCD_WRITE_ONLY        0       /* 1: R/W tied low, busy flag is not read   */
+#endif
+#ifndef LCD_CONTROLLER_KHZ
+#define LCD_CONTROLLER_KHZ    190     /* controller clock, measure it on the OSC  */
+#endif                                /* pins, 190kHz is the slowest 5V part      */
+
+#ifndef LCD_MULTI_DISPLAY
+#define LCD_MULTI_DISPLAY     0       /* 1: E line selected with lcd_select()     */
+#endif
+
+#if LCD_WRITE_ONLY && !LCD_IO_MODE
+#error "LCD_WRITE_ONLY needs LCD_IO_MODE=1"
+#endif
+#ifdef LCD_EMULATOR
+#include "hd44780_emu.h"
+#if !LCD_IO_MODE || LCD_MULTI_DISPLAY
+#error "LCD_EMULATOR needs LCD_IO_MODE=1 and LCD_MULTI_DISPLAY=0"
+#endif
+#endif
+#if LCD_MULTI_DISPLAY && !LCD_IO_MODE
+#error "LCD_MULTI_DISPLAY needs LCD_IO_MODE=1"
+#endif
+
+/* timed waits are used in write only mode and for groups of displays */
+#define LCD_TIMED_WAIT  (LCD_WRITE_ONLY || LCD_MULTI_DISPLAY)
+
+#if LCD_TIMED_WAIT
+/* execution times from the HD44780U data sheet at fosc=270kHz, in us */
+#define LCD_EXEC_TIME_CLEAR   1520    /* clear display, return home               */
+#define LCD_EXEC_TIME_CMD     37      /* all other instructions                   */
+#define LCD_EXEC_TIME_DATA    41      /* data write, 37us + 4us address update    */
+
+/* execution time in us at LCD_CONTROLLER_KHZ, rounded up */
+#define LCD_EXEC_US(t)  ( ((t)*270UL + LCD_CONTROLLER_KHZ - 1) / LCD_CONTROLLER_KHZ )
+
+/* what the last write is still doing */
+#define LCD_PENDING_NONE      0
+#define LCD_PENDING_CMD       1
+#define LCD_PENDING_DATA      2
+#define LCD_PENDING_CLEAR     3
+
+/* DDRAM memory lines, the address counter runs from the end of one */
+/* to the start of the next, e.g. 0x27->0x40 and 0x67->0x00         */
+#if LCD_CONTROLLER_KS0073 && LCD_LINES==4
+#define LCD_MEM_LINE_MASK     0x60    /* 0x00, 0x20, 0x40, 0x60                   */
+#define LCD_MEM_LINE_STEP     0x20
+#define LCD_MEM_LINE_LEN      0x14
+#elif LCD_LINES==1
+#define LCD_MEM_LINE_MASK     0x00    /* one line 0x00-0x4F                       */
+#define LCD_MEM_LINE_STEP     0x80
+#define LCD_MEM_LINE_LEN      0x50
+#else
+#define LCD_MEM_LINE_MASK     0x40    /* 0x00-0x27, 0x40-0x67, also for 4 lines  */
+#define LCD_MEM_LINE_STEP     0x40
+#define LCD_MEM_LINE_LEN      0x28
+#endif
+#endif
+
+
 #if LCD_IO_MODE
+#ifdef LCD_EMULATOR
+#define lcd_e_delay()                 /* each E edge moves the emulator time */
+#define lcd_e_high()    LCD_E_PORT  |=  _BV(LCD_E_PIN); lcd_emu_bus();
+#define lcd_e_low()     LCD_E_PORT  &= ~_BV(LCD_E_PIN); lcd_emu_bus();
+#elif LCD_MULTI_DISPLAY
+#define lcd_e_delay()   __asm__ __volatile__( "rjmp 1f\n 1:" );
+#define lcd_e_high()    *lcd_e_port |=  lcd_e_mask;
+#define lcd_e_low()     *lcd_e_port &= ~lcd_e_mask;
+#else
 #define lcd_e_delay()   __asm__ __volatile__( "rjmp 1f\n 1:" );   //#define lcd_e_delay() __asm__ __volatile__( "rjmp 1f\n 1: rjmp 2f\n 2:" );
 #define lcd_e_high()    LCD_E_PORT  |=  _BV(LCD_E_PIN);
 #define lcd_e_low()     LCD_E_PORT  &= ~_BV(LCD_E_PIN);
+#endif
 #define lcd_e_toggle()  toggle_e()
+#if LCD_WRITE_ONLY
+#define lcd_rw_low()                  /* R/W is tied low */
+#define lcd_rw_ddr_set()
+#else
 #define lcd_rw_high()   LCD_RW_PORT |=  _BV(LCD_RW_PIN)
 #define lcd_rw_low()    LCD_RW_PORT &= ~_BV(LCD_RW_PIN)
+#define lcd_rw_ddr_set() DDR(LCD_RW_PORT) |= _BV(LCD_RW_PIN)
+#endif
+#if LCD_MULTI_DISPLAY
+#define lcd_e_ddr_set()               /* done by lcd_display_init() */
+#else
+#define lcd_e_ddr_set() DDR(LCD_E_PORT) |= _BV(LCD_E_PIN)
+#endif
 #define lcd_rs_high()   LCD_RS_PORT |=  _BV(LCD_RS_PIN)
 #define lcd_rs_low()    LCD_RS_PORT &= ~_BV(LCD_RS_PIN)
 #endif
@@ -82,6 +180,30 @@
 #if LCD_IO_MODE
 static void toggle_e(void);
 #endif
+#ifdef LCD_EMULATOR
+static void lcd_emu_bus(void);
+#endif
+#if LCD_TIMED_WAIT
+static void lcd_track(uint8_t data, uint8_t rs);
+#endif
+
+/*
+** local variables
+*/
+#if LCD_TIMED_WAIT
+static uint8_t lcd_address;                      /* software address counter    */
+static int8_t  lcd_increment = 1;                /* +1 or -1, from entry mode   */
+static uint8_t lcd_pending   = LCD_PENDING_NONE; /* wait before the next write  */
+static uint8_t lcd_in_cgram;                     /* address counter is in CGRAM */
+#endif
+#if LCD_WRAP_LINES==1
+static uint8_t lcd_wrapped;                      /* lcd_putc() just moved to the next line */
+#endif
+#if LCD_MULTI_DISPLAY
+static LCDDisplay *lcd_current;                  /* selected display or group   */
+static volatile uint8_t *lcd_e_port;             /* E line(s) of lcd_current    */
+static uint8_t lcd_e_mask;
+#endif
 
 /*
 ** local functions
@@ -89,6 +211,42 @@ static void toggle_e(void);
 
 
 
+#ifdef LCD_EMULATOR
+/*************************************************************************
+ delays only move the emulator time forward
+*************************************************************************/
+#define delay(us)  hd44780_emu_delay_us(us)
+
+
+/*************************************************************************
+Send the levels of the LCD lines to the emulator, called on each E edge.
+While E is high in read mode the emulator drives D4-D7, this is put in
+the PIN registers of the data lines.
+*************************************************************************/
+static void lcd_emu_bus(void)
+{
+    uint8_t data = 0;
+    uint8_t rw   = 0;
+
+
+    if ( LCD_DATA0_PORT & _BV(LCD_DATA0_PIN) ) data |= 0x01;
+    if ( LCD_DATA1_PORT & _BV(LCD_DATA1_PIN) ) data |= 0x02;
+    if ( LCD_DATA2_PORT & _BV(LCD_DATA2_PIN) ) data |= 0x04;
+    if ( LCD_DATA3_PORT & _BV(LCD_DATA3_PIN) ) data |= 0x08;
+#if !LCD_WRITE_ONLY
+    if ( LCD_RW_PORT & _BV(LCD_RW_PIN) ) rw = 1;
+#endif
+
+    data = hd44780_emu_bus( (LCD_E_PORT & _BV(LCD_E_PIN)) ? 1 : 0,
+                            (LCD_RS_PORT & _BV(LCD_RS_PIN)) ? 1 : 0, rw, data );
+
+    PIN(LCD_DATA0_PORT) = (PIN(LCD_DATA0_PORT) & ~_BV(LCD_DATA0_PIN)) | ( (data & 0x01) ? _BV(LCD_DATA0_PIN) : 0 );
+    PIN(LCD_DATA1_PORT) = (PIN(LCD_DATA1_PORT) & ~_BV(LCD_DATA1_PIN)) | ( (data & 0x02) ? _BV(LCD_DATA1_PIN) : 0 );
+    PIN(LCD_DATA2_PORT) = (PIN(LCD_DATA2_PORT) & ~_BV(LCD_DATA2_PIN)) | ( (data & 0x04) ? _BV(LCD_DATA2_PIN) : 0 );
+    PIN(LCD_DATA3_PORT) = (PIN(LCD_DATA3_PORT) & ~_BV(LCD_DATA3_PIN)) | ( (data & 0x08) ? _BV(LCD_DATA3_PIN) : 0 );
+}
+
+#else
 /*************************************************************************
  delay loop for small accurate delays: 16-bit counter, 4 cycles/loop
 *************************************************************************/
@@ -111,6 +269,7 @@ delay for a minimum of <us> microseconds
 the number of loops is calculated at compile-time from MCU clock frequency
 *************************************************************************/
 #define delay(us)  _delayFourCycles( ( ( 1*(XTAL/4000) )*us)/1000 )
+#endif
 
 
 #if LCD_IO_MODE
@@ -198,6 +357,9 @@ static void lcd_write(uint8_t data,uint8_t rs)
         LCD_DATA2_PORT |= _BV(LCD_DATA2_PIN);
         LCD_DATA3_PORT |= _BV(LCD_DATA3_PIN);
     }
+#if LCD_TIMED_WAIT
+    lcd_track(data, rs);
+#endif
 }
 #else
 #define lcd_write(d,rs) if (rs) *(volatile uint8_t*)(LCD_IO_DATA) = d; else *(volatile uint8_t*)(LCD_IO_FUNCTION) = d;
@@ -212,7 +374,9 @@ Input:    rs     1: read data
                  0: read busy flag / address counter
 Returns:  byte read from LCD controller
 *************************************************************************/
-#if LCD_IO_MODE
+#if LCD_WRITE_ONLY
+/* the data bus can't be read, there is no lcd_read() */
+#elif LCD_IO_MODE
 static uint8_t lcd_read(uint8_t rs) 
 {
     uint8_t data;
@@ -279,6 +443,115 @@ static uint8_t lcd_read(uint8_t rs)
 #endif
 
 
+#if LCD_TIMED_WAIT
+/*************************************************************************
+Move the software address counter by one, the same way the controller
+does: CGRAM wraps at 0x3F, DDRAM goes from the end of one memory line
+to the start of the next one (0x27->0x40 and 0x67->0x00 with 2 lines).
+Input:    step   +1 or -1
+Returns:  none
+*************************************************************************/
+static void lcd_track_step(int8_t step)
+{
+    uint8_t base;
+
+    if ( lcd_in_cgram ) {
+        lcd_address = (lcd_address + step) & 0x3F;
+        return;
+    }
+
+    base = lcd_address & LCD_MEM_LINE_MASK;
+    if ( step > 0 ) {
+        if ( (uint8_t)(lcd_address - base) < LCD_MEM_LINE_LEN - 1 )
+            lcd_address++;
+        else
+            lcd_address = (base + LCD_MEM_LINE_STEP) & 0x7F;
+    } else {
+        if ( lcd_address != base )
+            lcd_address--;
+        else
+            lcd_address = ((base - LCD_MEM_LINE_STEP) & 0x7F) + LCD_MEM_LINE_LEN - 1;
+    }
+}/* lcd_track_step */
+
+
+/*************************************************************************
+Keep track of the address counter and of the execution time of a write,
+for when the R/W line is tied low or several displays are written at once
+and the busy flag can't be read.
+Input:    data   byte written to LCD controller
+          rs     1: data written
+                 0: instruction written
+Returns:  none
+*************************************************************************/
+static void lcd_track(uint8_t data, uint8_t rs)
+{
+    if (rs) {
+        /* data write to DDRAM or CGRAM */
+        lcd_track_step(lcd_increment);
+        lcd_pending = LCD_PENDING_DATA;
+        return;
+    }
+
+    lcd_pending = LCD_PENDING_CMD;
+    if ( data & (1<<LCD_DDRAM) ) {
+        lcd_address = data & 0x7F;
+        lcd_in_cgram = 0;
+    } else if ( data & (1<<LCD_CGRAM) ) {
+        lcd_address = data & 0x3F;
+        lcd_in_cgram = 1;
+    } else if ( data & (1<<LCD_FUNCTION) ) {
+        /* function set, the address counter is not changed */
+    } else if ( data & (1<<LCD_MOVE) ) {
+        if ( !(data & (1<<LCD_MOVE_DISP)) )
+            lcd_track_step( (data & (1<<LCD_MOVE_RIGHT)) ? 1 : -1 );
+    } else if ( data & (1<<LCD_ON) ) {
+        /* display on/off control */
+    } else if ( data & (1<<LCD_ENTRY_MODE) ) {
+        lcd_increment = ( data & (1<<LCD_ENTRY_INC) ) ? 1 : -1;
+    } else {
+        /* clear display also sets the entry mode to increment */
+        if ( data & (1<<LCD_CLR) )
+            lcd_increment = 1;
+        lcd_address = 0;
+        lcd_in_cgram = 0;
+        lcd_pending = LCD_PENDING_CLEAR;
+    }
+}/* lcd_track */
+
+
+/*************************************************************************
+waits for the execution time of the last write, returns address counter
+The full execution time is always waited, there is no timer to tell how
+much of it has already gone by since the write.
+*************************************************************************/
+static uint8_t lcd_waittimed(void)
+{
+    /* the delays must be constants, they are calculated at compile-time */
+    if ( lcd_pending == LCD_PENDING_DATA )
+        delay(LCD_EXEC_US(LCD_EXEC_TIME_DATA));
+    else if ( lcd_pending == LCD_PENDING_CMD )
+        delay(LCD_EXEC_US(LCD_EXEC_TIME_CMD));
+    else if ( lcd_pending == LCD_PENDING_CLEAR )
+        delay(LCD_EXEC_US(LCD_EXEC_TIME_CLEAR));
+    lcd_pending = LCD_PENDING_NONE;
+
+    return lcd_address;
+
+}/* lcd_waittimed */
+#endif
+
+
+#if LCD_WRITE_ONLY
+/*************************************************************************
+waits for the last write, returns address counter
+*************************************************************************/
+static uint8_t lcd_waitbusy(void)
+{
+    return lcd_waittimed();
+}
+
+#else
 /*************************************************************************
 loops while lcd is busy, returns address counter
 *************************************************************************/
@@ -287,6 +560,12 @@ static uint8_t lcd_waitbusy(void)
 {
     register uint8_t c;
     
+#if LCD_MULTI_DISPLAY
+    /* a group of displays can't be read, they would all drive the bus */
+    if ( lcd_current->Group )
+        return lcd_waittimed();
+#endif
+
     /* wait until busy flag is cleared */
     while ( (c=lcd_read(0)) & (1<<LCD_BUSY)) {}
     
@@ -297,6 +576,7 @@ static uint8_t lcd_waitbusy(void)
     return (lcd_read(0));  // return address counter
     
 }/* lcd_waitbusy */
+#endif
 
 
 /*************************************************************************
@@ -354,11 +634,102 @@ Returns: none
 *************************************************************************/
 void lcd_command(uint8_t cmd)
 {
+#if LCD_WRAP_LINES==1
+    lcd_wrapped = 0;
+#endif
     lcd_waitbusy();
     lcd_write(cmd,0);
 }
 
 
+/*************************************************************************
+Send a byte to the LCD controller without checking the busy flag.
+The caller must make sure the last instruction has finished.
+Input:    data   byte to write to LCD controller
+          rs     1: write data
+                 0: write instruction
+Returns:  none
+*************************************************************************/
+void lcd_write_nowait(uint8_t data, uint8_t rs)
+{
+    lcd_write(data,rs);
+}
+
+
+#if LCD_MULTI_DISPLAY
+/*************************************************************************
+Set up a display descriptor and its E line
+Input:    disp   descriptor to set up
+          port   port of the E line, for example &PORTB
+          pin    pin of the E line
+Returns:  none
+*************************************************************************/
+void lcd_display_init(LCDDisplay *disp, volatile uint8_t *port, uint8_t pin)
+{
+    disp->EPort   = port;
+    disp->EMask   = _BV(pin);
+    disp->Group   = 0;
+    disp->Address = 0;
+
+    *port &= ~_BV(pin);                 /* E low, the display ignores the bus */
+    DDR(*port) |= _BV(pin);
+}
+
+
+/*************************************************************************
+Add a display to a group, a group is written like one display
+Input:    group  group descriptor, set up with lcd_display_init() first
+          disp   display to add
+Returns:  0 if the E lines are not on the same port, else 1
+*************************************************************************/
+uint8_t lcd_display_group(LCDDisplay *group, const LCDDisplay *disp)
+{
+    if ( group->EPort != disp->EPort )
+        return 0;
+
+    group->EMask |= disp->EMask;
+    group->Group  = 1;
+    return 1;
+}
+
+
+/*************************************************************************
+Select the display (or group) the other lcd functions work on
+The last write to the old display is finished first.
+Input:    disp   display descriptor
+Returns:  none
+*************************************************************************/
+void lcd_select(LCDDisplay *disp)
+{
+    if ( lcd_current == disp )
+        return;
+
+    if ( lcd_current ) {
+        lcd_waitbusy();
+        /* bit 7 is free, the largest address is 0x7F */
+        lcd_current->Address = lcd_address | (lcd_in_cgram ? 0x80 : 0);
+    }
+#if LCD_WRAP_LINES==1
+    lcd_wrapped  = 0;
+#endif
+    lcd_current  = disp;
+    lcd_e_port   = disp->EPort;
+    lcd_e_mask   = disp->EMask;
+    lcd_address  = disp->Address & 0x7F;
+    lcd_in_cgram = (disp->Address & 0x80) ? 1 : 0;
+}
+
+
+/*************************************************************************
+Return the selected display
+*************************************************************************/
+LCDDisplay *lcd_selected(void)
+{
+    return lcd_current;
+}
+#endif
+
+
 /*************************************************************************
 Send data byte to LCD controller 
 Input:   data to send to LCD controller, see HD44780 data sheet
@@ -366,6 +737,9 @@ Returns: none
 *************************************************************************/
 void lcd_data(uint8_t data)
 {
+#if LCD_WRAP_LINES==1
+    lcd_wrapped = 0;
+#endif
     lcd_waitbusy();
     lcd_write(data,1);
 }
@@ -413,6 +787,7 @@ void lcd_gotoaddress(uint8_t addr)
 } /* lcd_gotoaddress */
 
 
+#if !LCD_WRITE_ONLY
 /*************************************************************************
 Read character at a specified position
 Input:    x  horizontal position  (0: left most position)
@@ -425,16 +800,19 @@ uint8_t lcd_getcharacterataddress(uint8_t addr)
 	lcd_waitbusy();
 	return lcd_read(1);
 }
+#endif
 
 
 /*************************************************************************
 Return the current address counter
+In write only mode this is the address counter kept in software
 *************************************************************************/
 uint8_t lcd_getcurrentaddress(void)
 {
     return lcd_waitbusy();
 }
 
+#if !LCD_WRITE_ONLY
 /*************************************************************************
 Read character at a specified position
 Input:    x  horizontal position  (0: left most position)
@@ -447,6 +825,7 @@ uint8_t lcd_getxy(uint8_t x, uint8_t y)
 	lcd_waitbusy();
 	return lcd_read(1);
 }
+#endif
 
 
 /*************************************************************************
@@ -480,35 +859,58 @@ void lcd_putc(char c)
     pos = lcd_waitbusy();   // read busy-flag and address counter
     if (c=='\n')
     {
+#if LCD_WRAP_LINES==1
+        /* a full line already moved to the next line, don't skip one */
+        if ( lcd_wrapped )
+            lcd_wrapped = 0;
+        else
+#endif
         lcd_newline(pos);
     }
     else
     {
+        lcd_write(c, 1);
 #if LCD_WRAP_LINES==1
+        /* Move to the next line right after the last character of a line is written.
+         * Checking the address before writing does not work on 4 line HD44780 displays:
+         * the address after line 1 is the start of line 3 (0x14), and the address after
+         * line 3 is the start of line 2 (0x28 goes to 0x40). */
+        lcd_wrapped = 1;
 #if LCD_LINES==1
-        if ( pos == LCD_START_LINE1+LCD_DISP_LENGTH ) {
+        if ( pos == LCD_START_LINE1+LCD_DISP_LENGTH-1 ) {
+            lcd_waitbusy();
             lcd_write((1<<LCD_DDRAM)+LCD_START_LINE1,0);
+        }else {
+            lcd_wrapped = 0;
         }
 #elif LCD_LINES==2
-        if ( pos == LCD_START_LINE1+LCD_DISP_LENGTH ) {
-            lcd_write((1<<LCD_DDRAM)+LCD_START_LINE2,0);    
-        }else if ( pos == LCD_START_LINE2+LCD_DISP_LENGTH ){
+        if ( pos == LCD_START_LINE1+LCD_DISP_LENGTH-1 ) {
+            lcd_waitbusy();
+            lcd_write((1<<LCD_DDRAM)+LCD_START_LINE2,0);
+        }else if ( pos == LCD_START_LINE2+LCD_DISP_LENGTH-1 ){
+            lcd_waitbusy();
             lcd_write((1<<LCD_DDRAM)+LCD_START_LINE1,0);
+        }else {
+            lcd_wrapped = 0;
         }
 #elif LCD_LINES==4
-        if ( pos == LCD_START_LINE1+LCD_DISP_LENGTH ) {
-            lcd_write((1<<LCD_DDRAM)+LCD_START_LINE2,0);    
-        }else if ( pos == LCD_START_LINE2+LCD_DISP_LENGTH ) {
+        if ( pos == LCD_START_LINE1+LCD_DISP_LENGTH-1 ) {
+            lcd_waitbusy();
+            lcd_write((1<<LCD_DDRAM)+LCD_START_LINE2,0);
+        }else if ( pos == LCD_START_LINE2+LCD_DISP_LENGTH-1 ) {
+            lcd_waitbusy();
             lcd_write((1<<LCD_DDRAM)+LCD_START_LINE3,0);
-        }else if ( pos == LCD_START_LINE3+LCD_DISP_LENGTH ) {
+        }else if ( pos == LCD_START_LINE3+LCD_DISP_LENGTH-1 ) {
+            lcd_waitbusy();
             lcd_write((1<<LCD_DDRAM)+LCD_START_LINE4,0);
-        }else if ( pos == LCD_START_LINE4+LCD_DISP_LENGTH ) {
+        }else if ( pos == LCD_START_LINE4+LCD_DISP_LENGTH-1 ) {
+            lcd_waitbusy();
             lcd_write((1<<LCD_DDRAM)+LCD_START_LINE1,0);
+        }else {
+            lcd_wrapped = 0;
         }
 #endif
-        lcd_waitbusy();
 #endif
-        lcd_write(c, 1);
     }
 
 }/* lcd_putc */
@@ -563,6 +965,19 @@ void lcd_init(uint8_t dispAttr)
      *  Initialize LCD to 4 bit I/O mode
      */
      
+#if LCD_MULTI_DISPLAY
+    /* the E lines are set up by lcd_display_init() */
+#elif LCD_WRITE_ONLY
+    if ( ( &LCD_DATA0_PORT == &LCD_DATA1_PORT) && ( &LCD_DATA1_PORT == &LCD_DATA2_PORT ) && ( &LCD_DATA2_PORT == &LCD_DATA3_PORT )
+      && ( &LCD_RS_PORT == &LCD_DATA0_PORT) && (&LCD_E_PORT == &LCD_DATA0_PORT)
+      && (LCD_DATA0_PIN == 0 ) && (LCD_DATA1_PIN == 1) && (LCD_DATA2_PIN == 2) && (LCD_DATA3_PIN == 3) 
+      && (LCD_RS_PIN == 4 ) && (LCD_E_PIN == 6 ) )
+    {
+        /* configure all port bits as output (all LCD lines on same port, no R/W line) */
+        DDR(LCD_DATA0_PORT) |= 0x5F;
+    }
+    else 
+#else
     if ( ( &LCD_DATA0_PORT == &LCD_DATA1_PORT) && ( &LCD_DATA1_PORT == &LCD_DATA2_PORT ) && ( &LCD_DATA2_PORT == &LCD_DATA3_PORT )
       && ( &LCD_RS_PORT == &LCD_DATA0_PORT) && ( &LCD_RW_PORT == &LCD_DATA0_PORT) && (&LCD_E_PORT == &LCD_DATA0_PORT)
       && (LCD_DATA0_PIN == 0 ) && (LCD_DATA1_PIN == 1) && (LCD_DATA2_PIN == 2) && (LCD_DATA3_PIN == 3) 
@@ -571,21 +986,23 @@ void lcd_init(uint8_t dispAttr)
         /* configure all port bits as output (all LCD lines on same port) */
         DDR(LCD_DATA0_PORT) |= 0x7F;
     }
-    else if ( ( &LCD_DATA0_PORT == &LCD_DATA1_PORT) && ( &LCD_DATA1_PORT == &LCD_DATA2_PORT ) && ( &LCD_DATA2_PORT == &LCD_DATA3_PORT )
-           && (LCD_DATA0_PIN == 0 ) && (LCD_DATA1_PIN == 1) && (LCD_DATA2_PIN == 2) && (LCD_DATA3_PIN == 3) )
+    else 
+#endif
+    if ( ( &LCD_DATA0_PORT == &LCD_DATA1_PORT) && ( &LCD_DATA1_PORT == &LCD_DATA2_PORT ) && ( &LCD_DATA2_PORT == &LCD_DATA3_PORT )
+      && (LCD_DATA0_PIN == 0 ) && (LCD_DATA1_PIN == 1) && (LCD_DATA2_PIN == 2) && (LCD_DATA3_PIN == 3) )
     {
         /* configure all port bits as output (all LCD data lines on same port, but control lines on different ports) */
         DDR(LCD_DATA0_PORT) |= 0x0F;
         DDR(LCD_RS_PORT)    |= _BV(LCD_RS_PIN);
-        DDR(LCD_RW_PORT)    |= _BV(LCD_RW_PIN);
-        DDR(LCD_E_PORT)     |= _BV(LCD_E_PIN);
+        lcd_rw_ddr_set();
+        lcd_e_ddr_set();
     }
     else
     {
         /* configure all port bits as output (LCD data and control lines on different ports */
         DDR(LCD_RS_PORT)    |= _BV(LCD_RS_PIN);
-        DDR(LCD_RW_PORT)    |= _BV(LCD_RW_PIN);
-        DDR(LCD_E_PORT)     |= _BV(LCD_E_PIN);
+        lcd_rw_ddr_set();
+        lcd_e_ddr_set();
         DDR(LCD_DATA0_PORT) |= _BV(LCD_DATA0_PIN);
         DDR(LCD_DATA1_PORT) |= _BV(LCD_DATA1_PIN);
         DDR(LCD_DATA2_PORT) |= _BV(LCD_DATA2_PIN);
@@ -601,7 +1018,7 @@ void lcd_init(uint8_t dispAttr)
    
     /* repeat last command */ 
     lcd_e_toggle();      
-    delay(64);           /* delay, busy flag can't be checked here */
+    delay(100);          /* data sheet: more than 100us, busy flag can't be checked here */
     
     /* repeat last command a third time */
     lcd_e_toggle();      
@@ -0,0 +1,244 @@
+/*   This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+*	\brief		Custom character cache for HD44780 displays
+*	\author		Pat Satyshur
+*	\version	1.0
+*	\date		4/13/2013
+*	\copyright	Copyright 2013, Pat Satyshur
+*	\ingroup 	interface
+*
+*	A copy of each glyph in CGRAM is kept in RAM. Glyphs are looked up by an 8 bit hash first and then compared row by row,
+*	so two glyphs with the same hash can not be mixed up.
+*
+*	@{
+*/
+
+#include <inttypes.h>
+#include <avr/pgmspace.h>
+#include "lcd.h"
+#include "lcd_ext.h"
+#include "lcd_cgram.h"
+
+#if LCD_MULTI_DISPLAY
+//Caches set up with lcd_cgram_init_display(), each one belongs to one display
+static LCDCgram *lcd_cgram_list;
+#else
+//The cache of the only display
+static LCDCgram lcd_cgram_default;
+#endif
+
+static uint16_t lcd_cgram_upload_count;
+
+//Get the cache of the selected display, 0 if it does not have one
+static LCDCgram *lcd_cgram_current(void)
+{
+#if LCD_MULTI_DISPLAY
+	LCDCgram *p;
+
+	for(p = lcd_cgram_list; p != 0; p = p->Next)
+	{
+		if(p->Display == lcd_selected())
+		{
+			return p;
+		}
+	}
+	return 0;
+#else
+	return &lcd_cgram_default;
+#endif
+}
+
+//Move a slot to the front of the LRU order
+static void lcd_cgram_touch(LCDCgram *cache, uint8_t slot)
+{
+	uint8_t i;
+
+	for(i = 0; cache->Order[i] != slot; i++);
+	for(; i > 0; i--)
+	{
+		cache->Order[i] = cache->Order[i - 1];
+	}
+	cache->Order[0] = slot;
+	cache->Slots[slot].InFrame = 1;
+}
+
+static void lcd_cgram_upload(LCDCgram *cache, uint8_t slot)
+{
+	uint8_t addr;
+	uint8_t i;
+
+	//Setting the CGRAM address moves the address counter out of DDRAM, put it back when done
+	addr = lcd_getcurrentaddress();
+	lcd_command((1 << LCD_CGRAM) | (slot << 3));
+	for(i = 0; i < LCD_CGRAM_GLYPH_SIZE; i++)
+	{
+		lcd_data(cache->Slots[slot].Glyph[i]);
+	}
+	lcd_command((1 << LCD_DDRAM) | addr);
+
+	lcd_cgram_upload_count++;
+}
+
+static uint8_t lcd_cgram_lookup(const uint8_t *rows)
+{
+	LCDCgram *cache = lcd_cgram_current();
+	uint8_t hash = 0;
+	uint8_t slot;
+	uint8_t i;
+
+	if(cache == 0)
+	{
+		return LCD_CGRAM_FALLBACK;
+	}
+
+	for(i = 0; i < LCD_CGRAM_GLYPH_SIZE; i++)
+	{
+		hash = ((hash << 1) | (hash >> 7)) ^ rows[i];
+	}
+
+	//Already in CGRAM?
+	for(slot = 0; slot < LCD_CGRAM_SLOTS; slot++)
+	{
+		if((cache->Slots[slot].Valid == 0) || (cache->Slots[slot].Hash != hash))
+		{
+			continue;
+		}
+		for(i = 0; i < LCD_CGRAM_GLYPH_SIZE; i++)
+		{
+			if(cache->Slots[slot].Glyph[i] != rows[i])
+			{
+				break;
+			}
+		}
+		if(i == LCD_CGRAM_GLYPH_SIZE)
+		{
+			lcd_cgram_touch(cache, slot);
+			return slot;
+		}
+	}
+
+	//Replace the least recently used glyph that is not on the screen in this frame
+	i = LCD_CGRAM_SLOTS;
+	do
+	{
+		if(i == 0)
+		{
+			return LCD_CGRAM_FALLBACK;
+		}
+		i--;
+		slot = cache->Order[i];
+	} while(cache->Slots[slot].InFrame != 0);
+
+	for(i = 0; i < LCD_CGRAM_GLYPH_SIZE; i++)
+	{
+		cache->Slots[slot].Glyph[i] = rows[i];
+	}
+	cache->Slots[slot].Hash = hash;
+	cache->Slots[slot].Valid = 1;
+	lcd_cgram_upload(cache, slot);
+	lcd_cgram_touch(cache, slot);
+	return slot;
+}
+
+//Forget what is in the CGRAM of one display
+static void lcd_cgram_clear(LCDCgram *cache)
+{
+	uint8_t i;
+
+	for(i = 0; i < LCD_CGRAM_SLOTS; i++)
+	{
+		cache->Slots[i].Valid = 0;
+		cache->Slots[i].InFrame = 0;
+		cache->Order[i] = i;
+	}
+}
+
+void lcd_cgram_init(void)
+{
+	LCDCgram *cache = lcd_cgram_current();
+
+	if(cache != 0)
+	{
+		lcd_cgram_clear(cache);
+	}
+	lcd_cgram_upload_count = 0;
+}
+
+#if LCD_MULTI_DISPLAY
+void lcd_cgram_init_display(LCDCgram *cache, LCDDisplay *disp)
+{
+	LCDCgram *p;
+
+	cache->Display = disp;
+	lcd_cgram_clear(cache);
+
+	for(p = lcd_cgram_list; p != 0; p = p->Next)
+	{
+		if(p == cache)
+		{
+			return;
+		}
+	}
+	cache->Next = lcd_cgram_list;
+	lcd_cgram_list = cache;
+}
+#endif
+
+void lcd_cgram_frame(void)
+{
+	LCDCgram *cache = lcd_cgram_current();
+	uint8_t i;
+
+	if(cache == 0)
+	{
+		return;
+	}
+	for(i = 0; i < LCD_CGRAM_SLOTS; i++)
+	{
+		cache->Slots[i].InFrame = 0;
+	}
+}
+
+uint8_t lcd_cgram_get(const uint8_t *glyph)
+{
+	uint8_t rows[LCD_CGRAM_GLYPH_SIZE];
+	uint8_t i;
+
+	for(i = 0; i < LCD_CGRAM_GLYPH_SIZE; i++)
+	{
+		rows[i] = glyph[i] & 0x1F;
+	}
+	return lcd_cgram_lookup(rows);
+}
+
+uint8_t lcd_cgram_get_p(const uint8_t *progmem_glyph)
+{
+	uint8_t rows[LCD_CGRAM_GLYPH_SIZE];
+	uint8_t i;
+
+	for(i = 0; i < LCD_CGRAM_GLYPH_SIZE; i++)
+	{
+		rows[i] = pgm_read_byte(&progmem_glyph[i]) & 0x1F;
+	}
+	return lcd_cgram_lookup(rows);
+}
+
+uint16_t lcd_cgram_uploads(void)
+{
+	return lcd_cgram_upload_count;
+}
+
+/** @} */
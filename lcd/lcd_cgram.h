@@ -0,0 +1,119 @@
+/*   This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+*	\brief		Custom character cache for HD44780 displays header file
+*	\author		Pat Satyshur
+*	\version	1.0
+*	\date		4/13/2013
+*	\copyright	Copyright 2013, Pat Satyshur
+*	\ingroup 	interface
+*
+*	The HD44780 has 8 user defined characters (codes 0-7) in CGRAM. Instead of loading fixed glyphs into fixed codes,
+*	ask for a glyph with lcd_cgram_get() and print the code it returns. A glyph is only sent to the display if it is
+*	not already in CGRAM, otherwise the code it is already at is returned. When all 8 codes are taken, the least recently
+*	used glyph is replaced.
+*
+*	Replacing a glyph changes every character on the screen with that code, so glyphs used in the current frame are
+*	never replaced. Call lcd_cgram_frame() at the start of each redraw. If a frame needs more than 8 different glyphs,
+*	lcd_cgram_get() returns LCD_CGRAM_FALLBACK for the extra ones.
+*
+*	Only 5x8 glyphs are supported. A glyph is 8 bytes, one per row, using the low 5 bits.
+*
+*	@{
+*/
+
+#ifndef _LCD_CGRAM_H_
+#define _LCD_CGRAM_H_
+
+#include <inttypes.h>
+#include "lcd.h"
+#include "lcd_ext.h"
+
+/*These settings can be added to lcd.h
+ * #define LCD_CGRAM_FALLBACK			0xFF	//Character returned when there is no free code in this frame (0xFF is a full block on the A00 ROM)
+ */
+
+#ifndef LCD_CGRAM_FALLBACK
+	#define LCD_CGRAM_FALLBACK			0xFF
+#endif
+
+//Number of user defined characters
+#define LCD_CGRAM_SLOTS					8
+
+//Bytes in a 5x8 glyph
+#define LCD_CGRAM_GLYPH_SIZE			8
+
+/** A copy of one CGRAM code */
+typedef struct LCDCgramSlot
+{
+	uint8_t Glyph[LCD_CGRAM_GLYPH_SIZE];
+	uint8_t Hash;
+	uint8_t Valid;		//Glyph holds what is in CGRAM
+	uint8_t InFrame;	//Used since the last lcd_cgram_frame()
+} LCDCgramSlot;
+
+/** What is in the CGRAM of one display */
+typedef struct LCDCgram
+{
+	LCDCgramSlot Slots[LCD_CGRAM_SLOTS];
+
+	/**Slot numbers, most recently used first*/
+	uint8_t Order[LCD_CGRAM_SLOTS];
+
+#if LCD_MULTI_DISPLAY
+	/**The display this CGRAM belongs to*/
+	LCDDisplay *Display;
+
+	/**Next cache set up with lcd_cgram_init_display()*/
+	struct LCDCgram *Next;
+#endif
+} LCDCgram;
+
+/** Forget what is in CGRAM. Call this after lcd_init(), CGRAM is not cleared at power up.
+*	With LCD_MULTI_DISPLAY set, this only clears the cache of the selected display.
+*/
+void lcd_cgram_init(void);
+
+#if LCD_MULTI_DISPLAY
+/** Give a display its own cache. Call this after lcd_init() for each display lcd_cgram is used on.
+*	The lcd_cgram functions use the cache of the display selected with lcd_select(). With no cache for it,
+*	lcd_cgram_get() returns LCD_CGRAM_FALLBACK. Glyphs sent while a group is selected go to every display in it,
+*	so do not use lcd_cgram on a group and on its displays one by one.
+*	\param[in] cache The cache.
+*	\param[in] disp The display, set up with lcd_display_init().
+*/
+void lcd_cgram_init_display(LCDCgram *cache, LCDDisplay *disp);
+#endif
+
+/** Start a new frame on the selected display. Glyphs used before this can be replaced again. */
+void lcd_cgram_frame(void);
+
+/** Get the character code for a glyph, sending the glyph to CGRAM if it is not there yet.
+*	The display address counter is put back after the glyph is sent, so this can be called while printing.
+*	\param[in] *glyph The 8 rows of the glyph.
+*
+*	\return The character code (0-7) to print, or LCD_CGRAM_FALLBACK if all codes are used in this frame.
+*/
+uint8_t lcd_cgram_get(const uint8_t *glyph);
+
+/** Same as lcd_cgram_get() for a glyph in program memory */
+uint8_t lcd_cgram_get_p(const uint8_t *progmem_glyph);
+
+/** Get the number of glyphs sent to CGRAM since lcd_cgram_init() */
+uint16_t lcd_cgram_uploads(void);
+
+#endif
+
+/** @} */
@@ -0,0 +1,113 @@
+/*   This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+*	\brief		Extra lcd.c functions header file
+*	\author		Pat Satyshur
+*	\version	1.0
+*	\date		4/6/2013
+*	\copyright	Copyright 2013, Pat Satyshur
+*	\ingroup 	interface
+*
+*	Functions added to lcd.c that are not in the lcd.h from Peter Fleury's library.
+*
+*	lcd.c also takes these settings from lcd.h:
+*	\code
+*	#define LCD_WRITE_ONLY			0		//1 if the R/W line is tied to GND. The busy flag is not read, lcd_getxy() and lcd_getcharacterataddress() are not available.
+*	#define LCD_CONTROLLER_KHZ		190		//Controller clock for the write only timing, measured on the OSC pins
+*	#define LCD_MULTI_DISPLAY		0		//1 if several displays share the data and RS lines. LCD_E_PORT and LCD_E_PIN are not used then.
+*	\endcode
+*
+*	With LCD_MULTI_DISPLAY set, set up a descriptor for each display and select one before calling any other lcd function:
+*	\code
+*	LCDDisplay Top, Bottom, Both;
+*	lcd_display_init(&Top, &PORTB, 4);
+*	lcd_display_init(&Bottom, &PORTB, 5);
+*	lcd_display_init(&Both, &PORTB, 4);
+*	lcd_display_group(&Both, &Bottom);
+*	lcd_select(&Both);
+*	lcd_init(LCD_DISP_ON);					//Both displays are set up at once
+*	lcd_select(&Top);
+*	lcd_puts("Top");
+*	\endcode
+*	A group sends each nibble once and pulses all of its E lines together. The busy flag of a group can't be read,
+*	so groups use the data sheet execution times (see LCD_CONTROLLER_KHZ).
+*	In write only mode the software address counter of each display is not updated by writes to a group,
+*	use lcd_gotoxy() on each display after a group write before relying on line wrapping.
+*
+*	@{
+*/
+
+#ifndef _LCD_EXT_H_
+#define _LCD_EXT_H_
+
+#include <inttypes.h>
+
+/** One display, or a group of displays written at once, when LCD_MULTI_DISPLAY is set */
+typedef struct LCDDisplay
+{
+	/**Port of the E line(s)*/
+	volatile uint8_t *EPort;
+
+	/**E line(s) on EPort*/
+	uint8_t EMask;
+
+	/**Set if this is a group of more than one display*/
+	uint8_t Group;
+
+	/**Software address counter, saved while another display is selected. Bit 7 is set if it points into CGRAM.*/
+	uint8_t Address;
+} LCDDisplay;
+
+/** Send a byte to the display without checking the busy flag. The caller must make sure the last instruction is done.
+*	\param[in] data The byte to send.
+*	\param[in] rs 1 to write data, 0 to write an instruction.
+*/
+void lcd_write_nowait(uint8_t data, uint8_t rs);
+
+/** Get the address counter of the display. In write only mode this is the address counter kept in software.
+*
+*	\return The address counter
+*/
+uint8_t lcd_getcurrentaddress(void);
+
+/** Set up a display descriptor. The E line is made an output and set low.
+*	\param[in] disp The descriptor.
+*	\param[in] port The port of the E line, for example &PORTB.
+*	\param[in] pin The pin of the E line.
+*/
+void lcd_display_init(LCDDisplay *disp, volatile uint8_t *port, uint8_t pin);
+
+/** Add a display to a group. The group must be set up with lcd_display_init() first.
+*	\param[in] group The group descriptor.
+*	\param[in] disp The display to add.
+*
+*	\return 1 if the display was added, 0 if its E line is not on the same port as the group
+*/
+uint8_t lcd_display_group(LCDDisplay *group, const LCDDisplay *disp);
+
+/** Select the display or group that the other lcd functions use. The last write to the old display is finished first.
+*	\param[in] disp The display or group.
+*/
+void lcd_select(LCDDisplay *disp);
+
+/** Get the selected display
+*
+*	\return The display or group selected with lcd_select()
+*/
+LCDDisplay *lcd_selected(void);
+
+#endif
+
+/** @} */
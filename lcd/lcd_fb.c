@@ -0,0 +1,284 @@
+/*   This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+*	\brief		Frame buffer for HD44780 displays
+*	\author		Pat Satyshur
+*	\version	1.0
+*	\date		3/30/2013
+*	\copyright	Copyright 2013, Pat Satyshur
+*	\ingroup 	interface
+*
+*	Each character has a dirty bit. The flush sends each run of changed characters with one DDRAM address instruction,
+*	and skips the address instruction if the address counter is already in the right place.
+*
+*	@{
+*/
+
+#include <inttypes.h>
+#include <avr/pgmspace.h>
+#include "lcd.h"
+#include "lcd_ext.h"
+#include "lcd_fb.h"
+
+//The address counter is not known
+#define LCD_FB_ADDR_UNKNOWN		0xFF
+
+//Used when only one display is in use
+static LCDFrameBuffer lcd_fb_default = { .Addr = LCD_FB_ADDR_UNKNOWN };
+
+//The frame buffer the lcd_fb functions draw into
+static LCDFrameBuffer *lcd_fb = &lcd_fb_default;
+
+#if LCD_MULTI_DISPLAY
+//Frame buffers flushed by lcd_fb_flush_all()
+static LCDFrameBuffer *lcd_fb_list;
+#endif
+
+//DDRAM address of the first character of each line
+static const uint8_t lcd_fb_line_start[LCD_LINES] =
+{
+	LCD_START_LINE1,
+#if LCD_LINES > 1
+	LCD_START_LINE2,
+#endif
+#if LCD_LINES > 2
+	LCD_START_LINE3,
+	LCD_START_LINE4,
+#endif
+};
+
+static inline uint8_t lcd_fb_is_dirty(uint8_t y, uint8_t x)
+{
+	return lcd_fb->Dirty[y][x >> 3] & (1 << (x & 0x07));
+}
+
+static void lcd_fb_set(uint8_t y, uint8_t x, char c)
+{
+	if(lcd_fb->Cells[y][x] != c)
+	{
+		lcd_fb->Cells[y][x] = c;
+		lcd_fb->Dirty[y][x >> 3] |= (1 << (x & 0x07));
+		lcd_fb->Changed = 1;
+	}
+}
+
+void lcd_fb_init(void)
+{
+	uint8_t x;
+	uint8_t y;
+
+	for(y = 0; y < LCD_LINES; y++)
+	{
+		for(x = 0; x < LCD_DISP_LENGTH; x++)
+		{
+			lcd_fb->Cells[y][x] = ' ';
+		}
+		for(x = 0; x < LCD_FB_DIRTY_BYTES; x++)
+		{
+			lcd_fb->Dirty[y][x] = 0;
+		}
+	}
+	lcd_fb->x = 0;
+	lcd_fb->y = 0;
+	lcd_fb->Addr = LCD_FB_ADDR_UNKNOWN;
+	lcd_fb->Changed = 0;
+}
+
+void lcd_fb_select(LCDFrameBuffer *fb)
+{
+	lcd_fb = fb;
+}
+
+#if LCD_MULTI_DISPLAY
+void lcd_fb_init_display(LCDFrameBuffer *fb, LCDDisplay *disp)
+{
+	LCDFrameBuffer *p;
+
+	fb->Display = disp;
+	lcd_fb = fb;
+	lcd_fb_init();
+
+	for(p = lcd_fb_list; p != 0; p = p->Next)
+	{
+		if(p == fb)
+		{
+			return;
+		}
+	}
+	fb->Next = lcd_fb_list;
+	lcd_fb_list = fb;
+}
+#endif
+
+void lcd_fb_clear(void)
+{
+	uint8_t x;
+	uint8_t y;
+
+	for(y = 0; y < LCD_LINES; y++)
+	{
+		for(x = 0; x < LCD_DISP_LENGTH; x++)
+		{
+			lcd_fb_set(y, x, ' ');
+		}
+	}
+	lcd_fb->x = 0;
+	lcd_fb->y = 0;
+}
+
+void lcd_fb_gotoxy(uint8_t x, uint8_t y)
+{
+	if((x < LCD_DISP_LENGTH) && (y < LCD_LINES))
+	{
+		lcd_fb->x = x;
+		lcd_fb->y = y;
+	}
+}
+
+void lcd_fb_putc(char c)
+{
+	if(c == '\n')
+	{
+		lcd_fb->x = 0;
+		if(++lcd_fb->y >= LCD_LINES)
+		{
+			lcd_fb->y = 0;
+		}
+		return;
+	}
+
+	lcd_fb_set(lcd_fb->y, lcd_fb->x, c);
+	if(++lcd_fb->x >= LCD_DISP_LENGTH)
+	{
+		lcd_fb->x = 0;
+		if(++lcd_fb->y >= LCD_LINES)
+		{
+			lcd_fb->y = 0;
+		}
+	}
+}
+
+void lcd_fb_puts(const char *s)
+{
+	char c;
+
+	while((c = *s++))
+	{
+		lcd_fb_putc(c);
+	}
+}
+
+void lcd_fb_puts_p(const char *progmem_s)
+{
+	char c;
+
+	while((c = pgm_read_byte(progmem_s++)))
+	{
+		lcd_fb_putc(c);
+	}
+}
+
+void lcd_fb_invalidate(void)
+{
+	uint8_t x;
+	uint8_t y;
+
+	for(y = 0; y < LCD_LINES; y++)
+	{
+		for(x = 0; x < LCD_FB_DIRTY_BYTES; x++)
+		{
+			lcd_fb->Dirty[y][x] = 0xFF;
+		}
+	}
+	lcd_fb->Addr = LCD_FB_ADDR_UNKNOWN;
+	lcd_fb->Changed = 1;
+}
+
+uint16_t lcd_fb_flush(void)
+{
+	uint16_t writes = 0;
+	uint8_t x;
+	uint8_t y;
+	uint8_t addr;
+
+	if(lcd_fb->Changed == 0)
+	{
+		return 0;
+	}
+	lcd_fb->Changed = 0;
+
+#if LCD_MULTI_DISPLAY
+	if(lcd_fb->Display != 0)
+	{
+		lcd_select(lcd_fb->Display);
+	}
+#endif
+
+	for(y = 0; y < LCD_LINES; y++)
+	{
+		x = 0;
+		while(x < LCD_DISP_LENGTH)
+		{
+			if(!lcd_fb_is_dirty(y, x))
+			{
+				x++;
+				continue;
+			}
+
+			//Start of a run of changed characters
+			addr = lcd_fb_line_start[y] + x;
+			if(lcd_fb->Addr != addr)
+			{
+				lcd_command((1<<LCD_DDRAM) | addr);
+				writes++;
+			}
+
+			//Send the run. A single clean character between two runs costs the same as an address instruction, so it is sent as well.
+			while((x < LCD_DISP_LENGTH) && (lcd_fb_is_dirty(y, x) || ((x + 1 < LCD_DISP_LENGTH) && lcd_fb_is_dirty(y, x + 1))))
+			{
+				lcd_data(lcd_fb->Cells[y][x]);
+				writes++;
+				addr++;
+				x++;
+			}
+			lcd_fb->Addr = addr;
+		}
+
+		for(x = 0; x < LCD_FB_DIRTY_BYTES; x++)
+		{
+			lcd_fb->Dirty[y][x] = 0;
+		}
+	}
+	return writes;
+}
+
+#if LCD_MULTI_DISPLAY
+uint16_t lcd_fb_flush_all(void)
+{
+	LCDFrameBuffer *selected = lcd_fb;
+	LCDFrameBuffer *p;
+	uint16_t writes = 0;
+
+	for(p = lcd_fb_list; p != 0; p = p->Next)
+	{
+		lcd_fb = p;
+		writes += lcd_fb_flush();
+	}
+	lcd_fb = selected;
+	return writes;
+}
+#endif
+
+/** @} */
@@ -0,0 +1,127 @@
+/*   This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+*	\brief		Frame buffer for HD44780 displays header file
+*	\author		Pat Satyshur
+*	\version	1.0
+*	\date		3/30/2013
+*	\copyright	Copyright 2013, Pat Satyshur
+*	\ingroup 	interface
+*
+*	The lcd_fb functions draw into a copy of the screen in RAM and do not touch the display.
+*	lcd_fb_flush() then sends only the characters that changed since the last flush.
+*	The display size comes from LCD_LINES, LCD_DISP_LENGTH and LCD_START_LINEx in lcd.h.
+*
+*	With one display the lcd_fb functions use a built in frame buffer. With LCD_MULTI_DISPLAY set, give each display its
+*	own frame buffer with lcd_fb_init_display(), pick the one to draw into with lcd_fb_select() and send all of them
+*	with lcd_fb_flush_all(). All displays must be the same size.
+*
+*	@{
+*/
+
+#ifndef _LCD_FB_H_
+#define _LCD_FB_H_
+
+#include <inttypes.h>
+#include "lcd.h"
+#include "lcd_ext.h"
+
+#define LCD_FB_DIRTY_BYTES		((LCD_DISP_LENGTH + 7) / 8)
+
+/** A copy of the screen of one display */
+typedef struct LCDFrameBuffer
+{
+	/**The characters on the screen*/
+	char Cells[LCD_LINES][LCD_DISP_LENGTH];
+
+	/**One bit for each character that changed since the last flush*/
+	uint8_t Dirty[LCD_LINES][LCD_FB_DIRTY_BYTES];
+
+	/**Set when any character changed since the last flush*/
+	uint8_t Changed;
+
+	/**The cursor*/
+	uint8_t x;
+	uint8_t y;
+
+	/**Where the display address counter is after the last flush, 0xFF if not known*/
+	uint8_t Addr;
+
+#if LCD_MULTI_DISPLAY
+	/**The display the frame buffer is flushed to*/
+	LCDDisplay *Display;
+
+	/**Next frame buffer flushed by lcd_fb_flush_all()*/
+	struct LCDFrameBuffer *Next;
+#endif
+} LCDFrameBuffer;
+
+/** Start using the frame buffer. The buffer is filled with spaces and marked clean, so call this right after lcd_init() or lcd_clrscr(). */
+void lcd_fb_init(void);
+
+/** Pick the frame buffer the other lcd_fb functions use.
+*	\param[in] fb The frame buffer.
+*/
+void lcd_fb_select(LCDFrameBuffer *fb);
+
+#if LCD_MULTI_DISPLAY
+/** Set up a frame buffer for a display and select it. The frame buffer is added to the ones sent by lcd_fb_flush_all().
+*	Call this right after lcd_init() or lcd_clrscr() on that display, like lcd_fb_init().
+*	\param[in] fb The frame buffer.
+*	\param[in] disp The display, set up with lcd_display_init().
+*/
+void lcd_fb_init_display(LCDFrameBuffer *fb, LCDDisplay *disp);
+#endif
+
+/** Fill the frame buffer with spaces and move the cursor to the top left */
+void lcd_fb_clear(void);
+
+/** Move the frame buffer cursor.
+*	\param[in] x The column (0 is the left most column).
+*	\param[in] y The line (0 is the first line).
+*/
+void lcd_fb_gotoxy(uint8_t x, uint8_t y);
+
+/** Put a character in the frame buffer at the cursor. '\n' moves to the start of the next line, and the end of a line wraps to the next one.
+*	\param[in] c The character.
+*/
+void lcd_fb_putc(char c);
+
+/** Put a string in the frame buffer at the cursor */
+void lcd_fb_puts(const char *s);
+
+/** Put a string from program memory in the frame buffer at the cursor */
+void lcd_fb_puts_p(const char *progmem_s);
+
+/** Mark every character as changed, so the next flush redraws the whole display. Use this if something else wrote to the display or moved its cursor. */
+void lcd_fb_invalidate(void);
+
+/** Send the changed characters to the display. With LCD_MULTI_DISPLAY set, the display of the frame buffer is selected first.
+*
+*	\return The number of instructions and characters sent to the display
+*/
+uint16_t lcd_fb_flush(void);
+
+#if LCD_MULTI_DISPLAY
+/** Send the changed characters of every frame buffer set up with lcd_fb_init_display(). Displays with no changes are skipped.
+*
+*	\return The number of instructions and characters sent to the displays
+*/
+uint16_t lcd_fb_flush_all(void);
+#endif
+
+#endif
+
+/** @} */
@@ -0,0 +1,168 @@
+/*   This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+*	\brief		Queued HD44780 writes
+*	\author		Pat Satyshur
+*	\version	1.0
+*	\date		4/6/2013
+*	\copyright	Copyright 2013, Pat Satyshur
+*	\ingroup 	interface
+*
+*	The queue is a single producer, single consumer ring buffer with free running indexes, the same as the UART buffers.
+*	Only the main code moves the head and only lcd_queue_tick() moves the tail, so interrupts are never turned off.
+*
+*	@{
+*/
+
+#include <inttypes.h>
+#include "lcd.h"
+#include "lcd_ext.h"
+#include "lcd_queue.h"
+
+#define LCD_QUEUE_MASK			(LCD_QUEUE_SIZE - 1)
+
+//Ticks to wait after a byte is sent. The byte goes out at the next tick after the count runs out, so one tick is taken off.
+#define LCD_QUEUE_TICKS(us)		((((us) + LCD_QUEUE_TICK_US - 1) / LCD_QUEUE_TICK_US) - 1)
+
+//lcd_queue_wait is 8 bits, so the longest wait must fit in 255 ticks (LCD_QUEUE_TICK_US of 8 or more with the default clear time)
+#if (LCD_QUEUE_TICKS(LCD_QUEUE_CLEAR_US) > 255) || (LCD_QUEUE_TICKS(LCD_QUEUE_EXEC_US) > 255)
+	#error: LCD_QUEUE_TICK_US is too short for LCD_QUEUE_CLEAR_US, the wait does not fit in 255 ticks
+#endif
+
+//Bit 8 of a queue entry is RS
+#define LCD_QUEUE_RS			0x100
+
+static volatile uint16_t lcd_queue_buffer[LCD_QUEUE_SIZE];
+static volatile uint8_t lcd_queue_head = 0;
+static volatile uint8_t lcd_queue_tail = 0;
+static volatile uint8_t lcd_queue_wait = 0;
+
+static uint8_t lcd_queue_put(uint16_t entry)
+{
+	uint8_t head = lcd_queue_head;
+
+#if LCD_QUEUE_BLOCK_WHEN_FULL == 1
+	while((uint8_t)(head - lcd_queue_tail) >= LCD_QUEUE_SIZE);
+#else
+	if((uint8_t)(head - lcd_queue_tail) >= LCD_QUEUE_SIZE)
+	{
+		return 0;
+	}
+#endif
+
+	lcd_queue_buffer[head & LCD_QUEUE_MASK] = entry;
+	lcd_queue_head = head + 1;
+	return 1;
+}
+
+uint8_t lcd_queue_command(uint8_t cmd)
+{
+	return lcd_queue_put(cmd);
+}
+
+uint8_t lcd_queue_data(uint8_t data)
+{
+	return lcd_queue_put(LCD_QUEUE_RS | data);
+}
+
+uint8_t lcd_queue_gotoxy(uint8_t x, uint8_t y)
+{
+	uint8_t addr;
+
+#if LCD_LINES==1
+	addr = LCD_START_LINE1;
+#elif LCD_LINES==2
+	addr = (y == 0) ? LCD_START_LINE1 : LCD_START_LINE2;
+#else
+	if(y == 0)
+		addr = LCD_START_LINE1;
+	else if(y == 1)
+		addr = LCD_START_LINE2;
+	else if(y == 2)
+		addr = LCD_START_LINE3;
+	else
+		addr = LCD_START_LINE4;
+#endif
+	return lcd_queue_put((1<<LCD_DDRAM) | (addr + x));
+}
+
+uint8_t lcd_queue_puts(const char *s)
+{
+	uint8_t count = 0;
+
+	while(*s)
+	{
+		if(lcd_queue_data(*s++) == 0)
+		{
+			break;
+		}
+		count++;
+	}
+	return count;
+}
+
+uint8_t lcd_queue_clrscr(void)
+{
+	return lcd_queue_put(1<<LCD_CLR);
+}
+
+uint8_t lcd_queue_home(void)
+{
+	return lcd_queue_put(1<<LCD_HOME);
+}
+
+uint8_t lcd_queue_free(void)
+{
+	return LCD_QUEUE_SIZE - (uint8_t)(lcd_queue_head - lcd_queue_tail);
+}
+
+uint8_t lcd_queue_empty(void)
+{
+	return (lcd_queue_head == lcd_queue_tail) && (lcd_queue_wait == 0);
+}
+
+void lcd_queue_tick(void)
+{
+	uint8_t tail = lcd_queue_tail;
+	uint16_t entry;
+
+	if(lcd_queue_wait > 0)
+	{
+		lcd_queue_wait--;
+		return;
+	}
+
+	if(tail == lcd_queue_head)
+	{
+		return;
+	}
+
+	entry = lcd_queue_buffer[tail & LCD_QUEUE_MASK];
+	lcd_queue_tail = tail + 1;
+
+	lcd_write_nowait(entry & 0xFF, (entry & LCD_QUEUE_RS) ? 1 : 0);
+
+	//Clear display and return home are the only slow instructions (the two lowest bits with RS low)
+	if(((entry & LCD_QUEUE_RS) == 0) && ((entry & 0xFC) == 0))
+	{
+		lcd_queue_wait = LCD_QUEUE_TICKS(LCD_QUEUE_CLEAR_US);
+	}
+	else
+	{
+		lcd_queue_wait = LCD_QUEUE_TICKS(LCD_QUEUE_EXEC_US);
+	}
+}
+
+/** @} */
@@ -0,0 +1,117 @@
+/*   This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+*	\brief		Queued HD44780 writes header file
+*	\author		Pat Satyshur
+*	\version	1.0
+*	\date		4/6/2013
+*	\copyright	Copyright 2013, Pat Satyshur
+*	\ingroup 	interface
+*
+*	Instructions and characters are put in a ring buffer and sent from a timer interrupt, so the code writing to the display never waits.
+*	Call lcd_queue_tick() from a timer ISR that runs every LCD_QUEUE_TICK_US. Each tick sends at most one byte, and only once the last instruction has had time to finish.
+*	Set up the display with lcd_init() first. While the queue is in use, do not call the other lcd_* functions, they would share the bus with the ISR.
+*
+*	@{
+*/
+
+#ifndef _LCD_QUEUE_H_
+#define _LCD_QUEUE_H_
+
+#include <inttypes.h>
+#include "lcd.h"
+
+/*These settings can be defined in lcd.h to change the LCD queue
+ * #define LCD_QUEUE_SIZE				64		//Number of bytes the queue can hold, this must be a power of 2 (max 128)
+ * #define LCD_QUEUE_TICK_US			100		//The period in us of the timer ISR that calls lcd_queue_tick(), LCD_QUEUE_CLEAR_US must be 255 ticks or less
+ * #define LCD_QUEUE_EXEC_US			50		//Time for most instructions and for a data write
+ * #define LCD_QUEUE_CLEAR_US			2000	//Time for the clear display and return home instructions
+ * #define LCD_QUEUE_BLOCK_WHEN_FULL	0		//Set to 1 to wait for room when the queue is full, 0 to drop the byte
+ */
+
+#ifndef LCD_QUEUE_SIZE
+	#define LCD_QUEUE_SIZE				64
+#endif
+
+#ifndef LCD_QUEUE_TICK_US
+	#define LCD_QUEUE_TICK_US			100
+#endif
+
+#ifndef LCD_QUEUE_EXEC_US
+	#define LCD_QUEUE_EXEC_US			50
+#endif
+
+#ifndef LCD_QUEUE_CLEAR_US
+	#define LCD_QUEUE_CLEAR_US			2000
+#endif
+
+#ifndef LCD_QUEUE_BLOCK_WHEN_FULL
+	#define LCD_QUEUE_BLOCK_WHEN_FULL	0
+#endif
+
+#if (LCD_QUEUE_SIZE & (LCD_QUEUE_SIZE - 1)) != 0
+	#error: LCD_QUEUE_SIZE must be a power of 2
+#endif
+
+#if LCD_QUEUE_SIZE > 128
+	#error: LCD_QUEUE_SIZE must be 128 or less
+#endif
+
+/** Queue an instruction.
+*	\param[in] cmd The instruction, see lcd.h.
+*
+*	\return 1 if the instruction was queued, 0 if the queue is full
+*/
+uint8_t lcd_queue_command(uint8_t cmd);
+
+/** Queue a data byte.
+*	\param[in] data The byte to write at the address counter.
+*
+*	\return 1 if the byte was queued, 0 if the queue is full
+*/
+uint8_t lcd_queue_data(uint8_t data);
+
+/** Queue a DDRAM address instruction to move the cursor.
+*	\param[in] x The column (0 is the left most column).
+*	\param[in] y The line (0 is the first line).
+*
+*	\return 1 if the instruction was queued, 0 if the queue is full
+*/
+uint8_t lcd_queue_gotoxy(uint8_t x, uint8_t y);
+
+/** Queue the characters of a string. There is no line feed handling, use lcd_queue_gotoxy().
+*
+*	\return The number of characters queued
+*/
+uint8_t lcd_queue_puts(const char *s);
+
+/** Queue a clear display instruction */
+uint8_t lcd_queue_clrscr(void);
+
+/** Queue a return home instruction */
+uint8_t lcd_queue_home(void);
+
+/** Returns the number of free places in the queue */
+uint8_t lcd_queue_free(void);
+
+/** Returns 1 once everything in the queue has been sent */
+uint8_t lcd_queue_empty(void);
+
+/** Send the next byte if the display is ready. Call this from a timer ISR every LCD_QUEUE_TICK_US. */
+void lcd_queue_tick(void);
+
+#endif
+
+/** @} */
@@ -0,0 +1,312 @@
+/*   This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+*	\brief		Host test of lcd.c, lcd_fb.c and lcd_cgram.c on the HD44780 emulator
+*	\author		Pat Satyshur
+*	\version	1.0
+*	\date		4/27/2013
+*	\copyright	Copyright 2013, Pat Satyshur
+*	\ingroup 	interface
+*
+*	Build and run with 'make emu_test' in this directory. The screen, the address counter and the bus cycles of each
+*	redraw are checked against the emulator, and the program returns non zero if any check fails.
+*	lcd.h is made from lcd.h.old with LCD_WRAP_LINES set to 1, for a 2x16 and a 4x20 HD44780 and a 4x20 KS0073 in 4 line mode.
+*
+*	@{
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include "lcd.h"
+#include "lcd_ext.h"
+#include "lcd_fb.h"
+#include "lcd_cgram.h"
+#include "hd44780_emu.h"
+
+#if (LCD_LINES < 2) || (LCD_WRAP_LINES != 1)
+	#error: The test needs a display with 2 or 4 lines and LCD_WRAP_LINES set to 1
+#endif
+
+//The DDRAM layout the controller uses. The address counter goes from the end of one memory line to the start of the next.
+#if LCD_CONTROLLER_KS0073 && (LCD_LINES == 4)
+	#define TEST_CONTROLLER			HD44780_EMU_KS0073
+	#define TEST_MEM_LINE_STEP		0x20	//Start of the second memory line
+	#define TEST_MEM_LINE_LEN		0x14	//Length of each memory line
+	#define TEST_MEM_LAST_LINE		0x60	//Start of the last memory line
+#else
+	#define TEST_CONTROLLER			HD44780_EMU_HD44780
+	#define TEST_MEM_LINE_STEP		0x40
+	#define TEST_MEM_LINE_LEN		0x28
+	#define TEST_MEM_LAST_LINE		0x40
+#endif
+
+static const uint8_t test_line_start[4] = { LCD_START_LINE1, LCD_START_LINE2, LCD_START_LINE3, LCD_START_LINE4 };
+
+static uint8_t test_failed;
+
+static void test_check(uint8_t ok, const char *what)
+{
+	printf("%s: %s\n", ok ? "pass" : "FAIL", what);
+	if(!ok)
+	{
+		test_failed = 1;
+	}
+}
+
+//Pad text with spaces to a whole line
+static void test_pad(char *buf, const char *text)
+{
+	memset(buf, ' ', LCD_DISP_LENGTH);
+	memcpy(buf, text, strlen(text));
+	buf[LCD_DISP_LENGTH] = 0;
+}
+
+//Compare a line of the emulated screen, the rest of the line after the expected text must be spaces
+static void test_line(uint8_t y, const char *expected, const char *what)
+{
+	char line[LCD_DISP_LENGTH + 1];
+	char padded[LCD_DISP_LENGTH + 1];
+
+	hd44780_emu_line(y, line);
+	test_pad(padded, expected);
+	if(strcmp(line, padded) != 0)
+	{
+		printf("      line %u is \"%s\", expected \"%s\"\n", y, line, padded);
+	}
+	test_check(strcmp(line, padded) == 0, what);
+}
+
+//Bus cycles since the last call, busy violations fail the test
+static uint32_t test_cycles(const char *what)
+{
+	HD44780EmuStats stats;
+
+	hd44780_emu_stats(&stats);
+	hd44780_emu_reset_stats();
+	printf("      %-28s %5lu bus cycles\n", what, (unsigned long)stats.BusCycles);
+	if(stats.BusyViolations != 0)
+	{
+		printf("      %lu busy violations\n", (unsigned long)stats.BusyViolations);
+		test_failed = 1;
+	}
+	return stats.BusCycles;
+}
+
+//The address counter kept by lcd.c (or read from the busy flag) must match the controller
+static void test_address(uint8_t expected, const char *what)
+{
+	uint8_t addr = lcd_getcurrentaddress();
+
+	if((addr != expected) || (hd44780_emu_address() != expected))
+	{
+		printf("      lcd.c 0x%02X, emulator 0x%02X, expected 0x%02X\n", addr, hd44780_emu_address(), expected);
+	}
+	test_check((addr == expected) && (hd44780_emu_address() == expected), what);
+}
+
+//Redrawing the whole screen compared to sending only the changes from the frame buffer
+static void test_fb(void)
+{
+	char line[LCD_DISP_LENGTH + 1];
+	uint32_t full;
+	uint32_t changed;
+
+	lcd_clrscr();
+	lcd_fb_init();
+	test_cycles("clear");
+
+	lcd_fb_puts("Temp: 21.5C\nFan:  50%");
+	lcd_fb_flush();
+	test_cycles("lcd_fb first frame");
+	test_line(0, "Temp: 21.5C", "lcd_fb first frame line 1");
+	test_line(1, "Fan:  50%", "lcd_fb first frame line 2");
+
+	//One digit on each line changes
+	lcd_fb_gotoxy(9, 0);
+	lcd_fb_putc('6');
+	lcd_fb_gotoxy(7, 1);
+	lcd_fb_putc('5');
+	lcd_fb_flush();
+	changed = test_cycles("lcd_fb two changed characters");
+	test_line(0, "Temp: 21.6C", "lcd_fb update line 1");
+	test_line(1, "Fan:  55%", "lcd_fb update line 2");
+
+	lcd_fb_flush();
+	test_check(test_cycles("lcd_fb nothing changed") == 0, "lcd_fb flush with no changes sends nothing");
+
+	//The same update drawn directly
+	lcd_gotoxy(0, 0);
+	test_pad(line, "Temp: 21.6C");
+	lcd_puts(line);
+	lcd_gotoxy(0, 1);
+	test_pad(line, "Fan:  55%");
+	lcd_puts(line);
+	full = test_cycles("full redraw");
+	test_check(changed < full, "lcd_fb update uses fewer bus cycles than a full redraw");
+}
+
+//A bar graph using custom characters, drawn twice
+static void test_cgram(void)
+{
+	static const uint8_t bars[3][LCD_CGRAM_GLYPH_SIZE] =
+	{
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F, 0x1F },
+		{ 0x00, 0x00, 0x00, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F },
+		{ 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F },
+	};
+	uint32_t first;
+	uint32_t second;
+	uint16_t uploads;
+	uint8_t code;
+	uint8_t frame;
+	uint8_t i;
+	uint8_t row;
+	uint8_t match = 1;
+
+	lcd_clrscr();
+	lcd_cgram_init();
+	test_cycles("clear");
+
+	for(frame = 0; frame < 2; frame++)
+	{
+		lcd_cgram_frame();
+		lcd_gotoxy(0, 0);
+		for(i = 0; i < 3; i++)
+		{
+			code = lcd_cgram_get(bars[i]);
+			lcd_putc(code);
+
+			for(row = 0; row < LCD_CGRAM_GLYPH_SIZE; row++)
+			{
+				if(hd44780_emu_cgram(code, row) != bars[i][row])
+				{
+					match = 0;
+				}
+			}
+		}
+
+		if(frame == 0)
+		{
+			first = test_cycles("lcd_cgram first frame");
+			uploads = lcd_cgram_uploads();
+		}
+		else
+		{
+			second = test_cycles("lcd_cgram same glyphs again");
+		}
+	}
+
+	test_check(match, "lcd_cgram glyphs are in CGRAM at the returned codes");
+	test_check(uploads == 3, "lcd_cgram first frame uploads 3 glyphs");
+	test_check(lcd_cgram_uploads() == uploads, "lcd_cgram second frame uploads nothing");
+	test_check(second < first, "lcd_cgram second frame uses fewer bus cycles");
+	test_address(0x03, "address counter back in DDRAM after the uploads");
+}
+
+//The address counter goes from the end of one memory line to the next, and from the last one back to 0x00
+static void test_mem_wrap(void)
+{
+	lcd_clrscr();
+	test_cycles("clear");
+
+	//Three characters from the second to last address of memory line 1, the last one is at the start of line 2
+	lcd_command((1<<LCD_DDRAM) | (TEST_MEM_LINE_LEN - 2));
+	lcd_data('x');
+	lcd_data('y');
+	lcd_data('z');
+	test_address(TEST_MEM_LINE_STEP + 1, "address counter goes from the end of memory line 1 to line 2");
+	test_check(hd44780_emu_getc(0, 1) == 'z', "character after the end of memory line 1 is at the start of line 2");
+
+	lcd_command((1<<LCD_DDRAM) | (TEST_MEM_LAST_LINE + TEST_MEM_LINE_LEN - 1));
+	lcd_data('a');
+	lcd_data('b');
+	test_address(0x01, "address counter goes from the end of the last memory line to 0x00");
+	test_check(hd44780_emu_getc(0, 0) == 'b', "character after the last memory line is at the start of line 1");
+	test_cycles("memory wrap tests");
+}
+
+//lcd_gotoxy(), the lcd_putc() wrap at the end of the visible line and '\n' on every line
+static void test_lines(void)
+{
+	char what[80];
+	uint8_t y;
+	uint8_t next;
+	uint8_t ok;
+	uint8_t x;
+
+	for(y = 0; y < LCD_LINES; y++)
+	{
+		next = (y + 1) % LCD_LINES;
+		lcd_clrscr();
+
+		lcd_gotoxy(3, y);
+		sprintf(what, "lcd_gotoxy(3, %u) address", y);
+		test_address(test_line_start[y] + 3, what);
+		lcd_putc('0' + y);
+		sprintf(what, "lcd_putc after lcd_gotoxy(3, %u)", y);
+		test_check(hd44780_emu_getc(3, y) == '0' + y, what);
+
+		//The start of lines 3 and 4 can be the end of another line on the HD44780 (0x14 is right after line 1 on a 4x20)
+		lcd_gotoxy(0, y);
+		lcd_putc('C');
+		sprintf(what, "lcd_putc after lcd_gotoxy(0, %u)", y);
+		test_check(hd44780_emu_getc(0, y) == 'C', what);
+
+		lcd_gotoxy(LCD_DISP_LENGTH - 1, y);
+		lcd_puts("AB");
+		ok = (hd44780_emu_getc(LCD_DISP_LENGTH - 1, y) == 'A') && (hd44780_emu_getc(0, next) == 'B');
+		sprintf(what, "lcd_putc wrap from line %u to line %u", y + 1, next + 1);
+		test_check(ok, what);
+		sprintf(what, "address after the wrap from line %u", y + 1);
+		test_address(test_line_start[next] + 1, what);
+
+		lcd_gotoxy(5, y);
+		lcd_putc('\n');
+		sprintf(what, "lcd_putc('\\n') on line %u", y + 1);
+		test_address(test_line_start[next], what);
+
+		//A full line wraps by itself, the '\n' after it must not skip a line
+		lcd_gotoxy(0, y);
+		for(x = 0; x < LCD_DISP_LENGTH; x++)
+		{
+			lcd_putc('0' + x % 10);
+		}
+		lcd_putc('\n');
+		sprintf(what, "lcd_putc('\\n') after a full line %u", y + 1);
+		test_address(test_line_start[next], what);
+	}
+	test_cycles("line tests");
+}
+
+int main(void)
+{
+	printf("%ux%u %s\n", LCD_LINES, LCD_DISP_LENGTH, (TEST_CONTROLLER == HD44780_EMU_KS0073) ? "KS0073" : "HD44780");
+	hd44780_emu_init(LCD_LINES, LCD_DISP_LENGTH, 270, TEST_CONTROLLER);
+
+	lcd_init(LCD_DISP_ON);
+	test_cycles("lcd_init");
+
+	test_fb();
+	test_cgram();
+	test_mem_wrap();
+	test_lines();
+
+	hd44780_emu_print();
+	printf("%s\n", test_failed ? "FAILED" : "All tests passed");
+	return test_failed;
+}
+
+/** @} */
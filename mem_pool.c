@@ -0,0 +1,117 @@
+/*   This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+*	\brief		Fixed block memory pool
+*	\author		Pat Satyshur
+*	\version	1.0
+*	\date		3/16/2013
+*	\copyright	Copyright 2013, Pat Satyshur
+*	\ingroup 	hardware
+*
+*	@{
+*/
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "mem_pool.h"
+
+//All pools that have been set up
+static MemPool *MemPoolList = NULL;
+
+void MemPoolInit(MemPool *pool)
+{
+	uint8_t sreg = SREG;
+	uint8_t *block = pool->Storage;
+	MemPool *p;
+	uint8_t i;
+
+	cli();
+
+	//Link the blocks together, the last one points to NULL
+	pool->FreeList = block;
+	for(i = 1; i < pool->NumBlocks; i++)
+	{
+		*(void **)block = block + pool->BlockSize;
+		block += pool->BlockSize;
+	}
+	*(void **)block = NULL;
+
+	pool->FreeBlocks = pool->NumBlocks;
+	pool->MinFree = pool->NumBlocks;
+
+	//Add the pool to the list, unless it is already there
+	for(p = MemPoolList; p != NULL; p = p->Next)
+	{
+		if(p == pool)
+		{
+			SREG = sreg;
+			return;
+		}
+	}
+	pool->Next = MemPoolList;
+	MemPoolList = pool;
+
+	SREG = sreg;
+}
+
+void *MemPoolAlloc(MemPool *pool)
+{
+	uint8_t sreg = SREG;
+	void *block;
+
+	cli();
+	block = pool->FreeList;
+	if(block != NULL)
+	{
+		pool->FreeList = *(void **)block;
+		pool->FreeBlocks--;
+		if(pool->FreeBlocks < pool->MinFree)
+		{
+			pool->MinFree = pool->FreeBlocks;
+		}
+	}
+	SREG = sreg;
+
+	return block;
+}
+
+void MemPoolFree(MemPool *pool, void *block)
+{
+	uint8_t sreg = SREG;
+	uint16_t offset = (uint8_t *)block - pool->Storage;
+
+	if(((uint8_t *)block < pool->Storage) || (offset >= pool->BlockSize * pool->NumBlocks) || (offset % pool->BlockSize != 0))
+	{
+		return;		//Not the start of a block of this pool
+	}
+
+	cli();
+	if(pool->FreeBlocks >= pool->NumBlocks)
+	{
+		SREG = sreg;
+		return;		//Nothing is allocated, so this is a double free
+	}
+	*(void **)block = pool->FreeList;
+	pool->FreeList = block;
+	pool->FreeBlocks++;
+	SREG = sreg;
+}
+
+MemPool *MemPoolFirst(void)
+{
+	return MemPoolList;
+}
+
+/** @} */
@@ -0,0 +1,113 @@
+/*   This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+*	\brief		Fixed block memory pool header file
+*	\author		Pat Satyshur
+*	\version	1.0
+*	\date		3/16/2013
+*	\copyright	Copyright 2013, Pat Satyshur
+*	\ingroup 	hardware
+*
+*	A pool is a set of blocks of the same size, sized at compile time. Allocating and freeing a block take the same time no matter how full the pool is, and there is no fragmentation.
+*	Pools are safe to use from ISRs.
+*
+*	Example:
+*	\code
+*	MEM_POOL_DEFINE(MsgPool, 16, 8);		//8 blocks of 16 bytes
+*
+*	MemPoolInit(&MsgPool);
+*	uint8_t *msg = MemPoolAlloc(&MsgPool);
+*	...
+*	MemPoolFree(&MsgPool, msg);
+*	\endcode
+*
+*	@{
+*/
+
+#ifndef _MEM_POOL_H_
+#define _MEM_POOL_H_
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <avr/pgmspace.h>
+
+/** A pool of fixed size blocks. Make these with MEM_POOL_DEFINE(). */
+typedef struct MemPool
+{
+	/**The memory for the blocks*/
+	uint8_t *Storage;
+
+	/**The name of the pool, in flash*/
+	const char *Name;
+
+	/**The next pool in the list of all pools*/
+	struct MemPool *Next;
+
+	/**The first free block. Each free block holds a pointer to the next one.*/
+	void *FreeList;
+
+	/**The size of each block in bytes*/
+	uint16_t BlockSize;
+
+	/**The number of blocks*/
+	uint8_t NumBlocks;
+
+	/**The number of free blocks*/
+	uint8_t FreeBlocks;
+
+	/**The lowest FreeBlocks has been*/
+	uint8_t MinFree;
+} MemPool;
+
+/** The real block size, a free block must have room for the free list pointer */
+#define MEM_POOL_BLOCK_SIZE(size)	(((size) < sizeof(void *)) ? sizeof(void *) : (size))
+
+/** Make a pool called name with count blocks of size bytes. count must be 1 to 255. MemPoolInit() must be called before the pool is used. */
+#define MEM_POOL_DEFINE(name, size, count)																\
+	typedef char name##_CountCheck[(((count) > 0) && ((count) < 256)) ? 1 : -1];						\
+	static uint8_t name##_Storage[MEM_POOL_BLOCK_SIZE(size) * (count)];								\
+	static const char name##_Name[] PROGMEM = #name;													\
+	MemPool name = { name##_Storage, name##_Name, NULL, NULL, MEM_POOL_BLOCK_SIZE(size), (count), 0, 0 }
+
+/** Set up the free list of a pool and add it to the list of pools.
+*	\param[in] pool The pool to set up.
+*/
+void MemPoolInit(MemPool *pool);
+
+/** Get a block from a pool.
+*	\param[in] pool The pool.
+*
+*	\return The block, or NULL if the pool is empty
+*/
+void *MemPoolAlloc(MemPool *pool);
+
+/** Give a block back to a pool. Pointers that are not the start of a block of the pool are ignored, and so is a free when every block is already free.
+*	\param[in] pool The pool the block came from.
+*	\param[in] block The block.
+*/
+void MemPoolFree(MemPool *pool, void *block);
+
+/** Returns the first pool in the list of pools set up with MemPoolInit(), or NULL. Use the Next member to get the rest. */
+MemPool *MemPoolFirst(void);
+
+/** Returns the most blocks that have been in use at once */
+static inline uint8_t MemPoolMaxUsed(const MemPool *pool)
+{
+	return pool->NumBlocks - pool->MinFree;
+}
+
+#endif
+
+/** @} */
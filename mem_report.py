@@ -0,0 +1,193 @@
+#!/usr/bin/env python
+#   This program is free software: you can redistribute it and/or modify
+#    it under the terms of the GNU General Public License as published by
+#    the Free Software Foundation, either version 3 of the License, or
+#    (at your option) any later version.
+#
+#    This program is distributed in the hope that it will be useful,
+#    but WITHOUT ANY WARRANTY; without even the implied warranty of
+#    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#    GNU General Public License for more details.
+#
+#    You should have received a copy of the GNU General Public License
+#    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+"""Build time memory report for AVR projects.
+
+Shows the .data, .bss, .noinit, .progmem and .text use of each object file from the
+linker map file, and the biggest RAM, flash and EEPROM (EEMEM) symbols from the ELF file.
+
+Usage:
+    python mem_report.py <project.map> [project.elf] [-n N] [--nm avr-nm]
+
+The map file is made by adding -Wl,-Map=$(TARGET).map,--cref to LDFLAGS (the LUFA
+build system already does this). The symbol list needs avr-nm in the path.
+
+Pat Satyshur, 2013
+"""
+
+import re
+import subprocess
+import sys
+from collections import defaultdict
+
+SECTIONS = ('data', 'bss', 'noinit', 'progmem', 'text')
+
+#Data space addresses in the ELF file start at 0x800000, EEPROM at 0x810000.
+#The fuse, lock and signature sections are at 0x820000 and above.
+AVR_DATA_OFFSET = 0x800000
+AVR_EEPROM_OFFSET = 0x810000
+AVR_FUSE_OFFSET = 0x820000
+
+#One input section in the memory map: " .name  0xaddr  0xsize  file"
+#Long section names put the address, size and file on the next line
+SECTION_RE = re.compile(r'^ (\.\S+|COMMON)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(.+))?$')
+CONTINUE_RE = re.compile(r'^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(.+)$')
+
+
+def section_type(name):
+	"""Returns which of SECTIONS an input section counts towards, or None."""
+	if name == 'COMMON' or name.startswith('.bss'):
+		return 'bss'
+	if name.startswith('.noinit'):
+		return 'noinit'
+	if name.startswith('.data') or name.startswith('.rodata'):
+		return 'data'
+	if name.startswith('.progmem'):
+		return 'progmem'
+	if name.startswith('.text'):
+		return 'text'
+	return None
+
+
+def short_name(path):
+	"""Strip the directories from an object file or library member name."""
+	path = path.strip()
+	match = re.match(r'.*[/\\](.+\.a\(.+\))$', path)
+	if match:
+		return match.group(1)
+	return re.split(r'[/\\]', path)[-1]
+
+
+def parse_map(filename):
+	"""Returns {object file: {section type: bytes}} from a GNU ld map file."""
+	usage = defaultdict(lambda: defaultdict(int))
+	in_map = False
+	pending = None
+
+	with open(filename) as f:
+		for line in f:
+			line = line.rstrip('\r\n')
+			if line.startswith('Linker script and memory map'):
+				in_map = True
+				continue
+			if not in_map:
+				continue
+
+			if pending is not None:
+				match = CONTINUE_RE.match(line)
+				if match:
+					size = int(match.group(2), 16)
+					if size > 0:
+						usage[short_name(match.group(3))][pending] += size
+				pending = None
+				continue
+
+			match = SECTION_RE.match(line)
+			if not match:
+				continue
+			kind = section_type(match.group(1))
+			if kind is None:
+				continue
+			if match.group(2) is None:
+				pending = kind
+				continue
+			size = int(match.group(3), 16)
+			if size > 0:
+				usage[short_name(match.group(4))][kind] += size
+
+	return usage
+
+
+def address_space(addr):
+	"""Returns 'flash', 'RAM' or 'EEPROM' for an ELF address, or None for the fuse, lock and signature sections."""
+	if addr < AVR_DATA_OFFSET:
+		return 'flash'
+	if addr < AVR_EEPROM_OFFSET:
+		return 'RAM'
+	if addr < AVR_FUSE_OFFSET:
+		return 'EEPROM'
+	return None
+
+
+def read_symbols(elf, nm):
+	"""Returns a list of (size, name, 'RAM', 'flash' or 'EEPROM') from avr-nm."""
+	output = subprocess.check_output([nm, '--size-sort', '-S', elf]).decode()
+	symbols = []
+	for line in output.splitlines():
+		parts = line.split()
+		if len(parts) != 4:
+			continue
+		addr, size, kind, name = parts
+		if kind.lower() not in 'bdtr':
+			continue
+		space = address_space(int(addr, 16))
+		if space is None:
+			continue
+		symbols.append((int(size, 16), name, space))
+	symbols.sort(reverse=True)
+	return symbols
+
+
+def print_usage(usage):
+	print('%-32s' % 'Object' + ''.join('%9s' % s for s in SECTIONS) + '%9s' % 'RAM')
+	totals = defaultdict(int)
+	rows = sorted(usage.items(), key=lambda item: -(item[1]['data'] + item[1]['bss'] + item[1]['noinit']))
+	for obj, sizes in rows:
+		ram = sizes['data'] + sizes['bss'] + sizes['noinit']
+		print('%-32s' % obj[:32] + ''.join('%9d' % sizes[s] for s in SECTIONS) + '%9d' % ram)
+		for s in SECTIONS:
+			totals[s] += sizes[s]
+	ram = totals['data'] + totals['bss'] + totals['noinit']
+	print('%-32s' % 'Total' + ''.join('%9d' % totals[s] for s in SECTIONS) + '%9d' % ram)
+
+
+def print_symbols(symbols, count):
+	for space in ('RAM', 'flash', 'EEPROM'):
+		if space == 'EEPROM' and not [s for s in symbols if s[2] == space]:
+			continue
+		print('')
+		print('Largest %s symbols:' % space)
+		for size, name, sym_space in [s for s in symbols if s[2] == space][:count]:
+			print('%8d  %s' % (size, name))
+
+
+def main(args):
+	count = 10
+	nm = 'avr-nm'
+	files = []
+
+	i = 0
+	while i < len(args):
+		if args[i] == '-n' and i + 1 < len(args):
+			count = int(args[i + 1])
+			i += 1
+		elif args[i] == '--nm' and i + 1 < len(args):
+			nm = args[i + 1]
+			i += 1
+		else:
+			files.append(args[i])
+		i += 1
+
+	if len(files) == 0:
+		print(__doc__)
+		return 1
+
+	print_usage(parse_map(files[0]))
+	if len(files) > 1:
+		print_symbols(read_symbols(files[1], nm), count)
+	return 0
+
+
+if __name__ == '__main__':
+	sys.exit(main(sys.argv[1:]))
@@ -27,10 +27,29 @@
 
 #include <inttypes.h>
 #include <avr/io.h>
+#include <util/atomic.h>
 #include "mem_usage.h"
 
 extern uint8_t _end;
 extern uint8_t __stack;
+extern uint8_t __heap_start;
+extern uint8_t __data_start;
+extern uint8_t __data_end;
+extern uint8_t __bss_start;
+extern uint8_t __bss_end;
+extern uint8_t __noinit_start;
+extern uint8_t __noinit_end;
+extern char *__brkval;
+
+#define STACK_CANARY		0xC5
+#define STACK_CANARY_WORD	0xC5C5
+
+//The lowest address the stack is known to have reached. Only moves down.
+//MemWatch() can run from an ISR, so this and MemMinMargin are only changed with interrupts off.
+static uint8_t * volatile MemLowWater = &__stack + 1;
+
+//The smallest free memory seen by MemWatch()
+static volatile uint16_t MemMinMargin = MEM_WATCH_NONE;
 
 //Fills all memory addresses with 0xC5
 void StackPaint(void) __attribute__ ((naked)) __attribute__ ((section (".init1")));
@@ -50,19 +69,144 @@ void StackPaint(void)
                     "    breq .loop"::);
 }
 
+//The top of the heap, the painted area starts here
+static uint8_t *MemHeapEnd(void)
+{
+	if(__brkval == 0)
+	{
+		return &__heap_start;
+	}
+	return (uint8_t *)__brkval;
+}
+
 //returns the number of unused bytes of memory
 uint16_t StackCount(void)
 {
-    const uint8_t *p = &_end;
-    uint16_t       c = 0;
+	const uint8_t *start = MemHeapEnd();
+	const uint8_t *p = start;
+	const uint8_t *end = &__stack;
+
+	//Check one byte to get to a word boundary, then check a word at a time
+	if(((uint16_t)p & 0x01) && (p <= end))
+	{
+		if(*p != STACK_CANARY)
+		{
+			return 0;
+		}
+		p++;
+	}
+
+	while((p < end) && (*(const uint16_t *)p == STACK_CANARY_WORD))
+	{
+		p += 2;
+	}
+
+	//The word that stopped the scan may still start with a canary
+	if((p <= end) && (*p == STACK_CANARY))
+	{
+		p++;
+	}
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if(p < MemLowWater)
+		{
+			MemLowWater = (uint8_t *)p;
+		}
+	}
+	return p - start;
+}
+
+uint16_t StackCountFast(void)
+{
+	uint8_t *heap;
+	uint8_t *lo;
+	uint8_t *hi;
+	uint8_t *mid;
+
+	//The search is short, so it all runs with interrupts off. Then MemWatch() cannot change MemLowWater in the middle of it.
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		heap = MemHeapEnd();
+		lo = heap;
+		hi = MemLowWater;
+
+		//Everything from hi up is known to be used. Find the lowest address in [lo, hi) that is not painted.
+		//Two bytes are checked at each step so a single 0xC5 byte on the stack does not stop the search.
+		while(lo < hi)
+		{
+			mid = lo + ((hi - lo) >> 1);
+			if((*mid == STACK_CANARY) && ((mid + 1 == hi) || (*(mid + 1) == STACK_CANARY)))
+			{
+				lo = mid + 1;
+			}
+			else
+			{
+				hi = mid;
+			}
+		}
+
+		if(hi < MemLowWater)
+		{
+			MemLowWater = hi;
+		}
+	}
 
-    while(*p == 0xC5 && p <= &__stack)
-    {
-        p++;
-        c++;
-    }
+	if(heap >= hi)
+	{
+		return 0;
+	}
+	return hi - heap;
+}
+
+uint16_t MemHeapStackMargin(void)
+{
+	uint8_t *heap = MemHeapEnd();
+	uint8_t *sp = (uint8_t *)SP;
+
+	if(sp <= heap)
+	{
+		return 0;
+	}
+	return sp - heap;
+}
+
+uint16_t MemWatch(void)
+{
+	uint16_t margin = StackCountFast();
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if(margin < MemMinMargin)
+		{
+			MemMinMargin = margin;
+		}
+	}
+	return margin;
+}
+
+uint16_t MemGetMinMargin(void)
+{
+	uint16_t margin;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		margin = MemMinMargin;
+	}
+	return margin;
+}
+
+void MemGetUsage(MemUsage *usage)
+{
+	uint8_t *heap = MemHeapEnd();
 
-    return c;
+	usage->Data = &__data_end - &__data_start;
+	usage->Bss = &__bss_end - &__bss_start;
+	usage->Noinit = &__noinit_end - &__noinit_start;
+	usage->Heap = heap - &__heap_start;
+	usage->Stack = &__stack - (uint8_t *)SP;
+	usage->Free = StackCount();
+	usage->StackMax = (&__stack + 1) - (heap + usage->Free);
 }
 
 /** @} */
\ No newline at end of file
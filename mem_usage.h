@@ -26,8 +26,65 @@
 #ifndef _MEM_USAGE_H_
 #define _MEM_USAGE_H_
 
+#include <inttypes.h>
+
+/** RAM use by area, in bytes. Filled in by MemGetUsage(). */
+typedef struct MemUsage
+{
+	/**Initialized static variables (.data)*/
+	uint16_t Data;
+
+	/**Zeroed static variables (.bss)*/
+	uint16_t Bss;
+
+	/**Static variables that are not cleared at reset (.noinit)*/
+	uint16_t Noinit;
+
+	/**The heap used by malloc()*/
+	uint16_t Heap;
+
+	/**Stack in use right now*/
+	uint16_t Stack;
+
+	/**The most stack used so far*/
+	uint16_t StackMax;
+
+	/**Never used memory between the heap and the stack (same as StackCount())*/
+	uint16_t Free;
+} MemUsage;
+
+/** Returns the number of unused bytes between the top of the heap and the lowest point the stack has reached.
+*	This checks every byte (a word at a time), so it takes longer with more free memory.
+*/
 uint16_t StackCount(void);
 
+/** Same as StackCount(), but finds the edge of the painted area with a binary search, so it is fast enough to call often.
+*	The search assumes the stack has written every byte it used. A large local buffer that was never written can hide part of the stack, so this can report more free memory than StackCount().
+*	The lowest point found is remembered, so the result never goes back up unless the heap shrinks.
+*/
+uint16_t StackCountFast(void);
+
+/** Returns the number of bytes between the top of the heap (__brkval) and the current stack pointer */
+uint16_t MemHeapStackMargin(void);
+
+/** Check the free memory between the top of the heap and the lowest point the stack has reached, and remember the smallest value.
+*	This is the painted gap from StackCountFast(), not the distance to the current stack pointer, so stack use between two calls is not missed.
+*	Call this periodically, for example from a timer ISR or the main loop.
+*	\return The current free memory (same as StackCountFast())
+*/
+uint16_t MemWatch(void);
+
+/** Returned by MemGetMinMargin() before MemWatch() has run */
+#define MEM_WATCH_NONE		0xFFFF
+
+/** Returns the smallest free memory seen by MemWatch(), or MEM_WATCH_NONE if it has not been called */
+uint16_t MemGetMinMargin(void);
+
+/** Get the RAM use of each area from the linker symbols. This calls StackCount(), so it takes as long.
+*	\param[out] usage Where to put the results.
+*/
+void MemGetUsage(MemUsage *usage);
+
 #endif
 
 /** @} */
\ No newline at end of file
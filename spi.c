@@ -24,12 +24,60 @@
 */
 
 #include <avr/io.h>
+#include <avr/interrupt.h>
+#include <stddef.h>
 #include "spi.h"
 
+//The device that has the bus, NULL if the bus is free
+static const SPIDevice * volatile SPI_Owner = NULL;
+
+#if SPI_USE_USART == 1
+//USART registers for the second SPI bus
+#define SPI_USART_CAT_(a, n, b)		a##n##b
+#define SPI_USART_CAT(a, n, b)		SPI_USART_CAT_(a, n, b)
+#define SPI_UCSRA					SPI_USART_CAT(UCSR, SPI_USART_NUMBER, A)
+#define SPI_UCSRB					SPI_USART_CAT(UCSR, SPI_USART_NUMBER, B)
+#define SPI_UCSRC					SPI_USART_CAT(UCSR, SPI_USART_NUMBER, C)
+#define SPI_UBRR					SPI_USART_CAT(UBRR, SPI_USART_NUMBER, )
+#define SPI_UDR						SPI_USART_CAT(UDR, SPI_USART_NUMBER, )
+
+//Bits in the USART registers, these are the same for all USARTs
+#define SPI_USART_BIT_RXC			7
+#define SPI_USART_BIT_TXC			6
+#define SPI_USART_BIT_UDRE			5
+#define SPI_USART_BIT_RXEN			4
+#define SPI_USART_BIT_TXEN			3
+#define SPI_USART_BIT_UMSEL1		7
+#define SPI_USART_BIT_UMSEL0		6
+#define SPI_USART_BIT_UDORD			2
+#define SPI_USART_BIT_UCPHA			1
+#define SPI_USART_BIT_UCPOL			0
+
+//The device that has the USART bus, NULL if the bus is free
+static const SPIDevice * volatile SPI_USARTOwner = NULL;
+
+static void SPIUSARTSetup(uint8_t ucsrc, uint8_t ubrr);
+static uint8_t SPIUSARTClockToUBRR(uint8_t clock);
+#endif
+
+#if SPI_USE_ISR == 1
+//Interrupt driven transfer state
+static const uint8_t * volatile SPI_TxData;
+static uint8_t * volatile SPI_RxData;
+static volatile uint16_t SPI_BytesLeft;
+static volatile uint8_t SPI_Busy = 0;
+static void (* volatile SPI_Done) (void);
+#endif
 
 void InitSPIMaster (uint8_t setup_cpol, uint8_t setup_cpha)
 {
-	if ((setup_cpol > 1) || (setup_cpha > 1))
+	InitSPIMasterClock(setup_cpol, setup_cpha, SPI_CLOCK_DIV4);
+	return;
+}
+
+void InitSPIMasterClock (uint8_t setup_cpol, uint8_t setup_cpha, uint8_t clock)
+{
+	if ((setup_cpol > 1) || (setup_cpha > 1) || (clock > SPI_CLOCK_MASK))
 	{
 		return;		//This is not allowed
 	}
@@ -43,12 +91,112 @@ void InitSPIMaster (uint8_t setup_cpol, uint8_t setup_cpha)
 	
 	//Setup SPI:
 	//	Master Mode
-	//	SCK is fosc/4
+	//	SCK is set by clock
 	SPCR = (1<<SPE)|(1<<MSTR)|(setup_cpol<<CPOL)|(setup_cpha<<CPHA);
+	SPISetClock(clock);
 
 	return;
 }
 
+void SPISetClock(uint8_t clock)
+{
+	SPCR = (SPCR & ~((1<<SPR1)|(1<<SPR0))) | (clock & 0x03);
+	if(clock & 0x04)
+	{
+		SPSR |= (1<<SPI2X);
+	}
+	else
+	{
+		SPSR &= ~(1<<SPI2X);
+	}
+}
+
+uint8_t SPIGetClock(void)
+{
+	uint8_t clock = SPCR & ((1<<SPR1)|(1<<SPR0));
+
+	if(SPSR & (1<<SPI2X))
+	{
+		clock |= 0x04;
+	}
+	return clock;
+}
+
+uint8_t SPIClockForFreq(uint32_t MaxFreqHz)
+{
+	//Settings from fastest to slowest, fosc/2 to fosc/128
+	static const uint8_t ClockSettings[] = { SPI_CLOCK_DIV2, SPI_CLOCK_DIV4, SPI_CLOCK_DIV8, SPI_CLOCK_DIV16,
+											 SPI_CLOCK_DIV32, SPI_CLOCK_DIV64, SPI_CLOCK_DIV128 };
+	uint32_t freq = F_CPU / 2;
+	uint8_t i;
+
+	for(i = 0; i < sizeof(ClockSettings) - 1; i++)
+	{
+		if(freq <= MaxFreqHz)
+		{
+			break;
+		}
+		freq >>= 1;
+	}
+	return ClockSettings[i];
+}
+
+void SPIDeviceInit(SPIDevice *dev, volatile uint8_t *CsPort, uint8_t CsPin, uint8_t mode, uint8_t clock, uint8_t BitOrder)
+{
+	dev->CsPort = CsPort;
+	dev->CsMask = (1<<CsPin);
+	dev->Spcr = (1<<SPE)|(1<<MSTR)|((mode & 0x03)<<CPHA)|(clock & 0x03);
+	if(BitOrder == SPI_LSB_FIRST)
+	{
+		dev->Spcr |= (1<<DORD);
+	}
+	dev->Spsr = (clock & 0x04) ? (1<<SPI2X) : 0;
+
+	//Chip select is an output and high
+	*CsPort |= dev->CsMask;
+	*(CsPort - 1) |= dev->CsMask;
+}
+
+uint8_t SPISelect(const SPIDevice *dev)
+{
+	uint8_t sreg = SREG;
+
+	cli();
+	if(SPI_Owner != NULL)
+	{
+		SREG = sreg;
+		return SPI_STAT_BUSY;
+	}
+	SPI_Owner = dev;
+
+	//Only change the settings if this device needs something different
+	if((SPCR & ~(1<<SPIE)) != dev->Spcr)
+	{
+		SPCR = dev->Spcr;
+	}
+	if((SPSR & (1<<SPI2X)) != dev->Spsr)
+	{
+		SPSR = dev->Spsr;
+	}
+
+	*dev->CsPort &= ~dev->CsMask;
+	SREG = sreg;
+	return SPI_STAT_OK;
+}
+
+void SPIDeselect(const SPIDevice *dev)
+{
+	uint8_t sreg = SREG;
+
+	cli();
+	if(SPI_Owner == dev)
+	{
+		*dev->CsPort |= dev->CsMask;
+		SPI_Owner = NULL;
+	}
+	SREG = sreg;
+}
+
 uint8_t SPISendByte(int8_t ByteToSend)
 {
 	int8_t resp;
@@ -68,5 +216,300 @@ uint8_t SPISendByte(int8_t ByteToSend)
 	return resp;
 }
 
+//Wait for the byte being shifted to finish. Returns 0 on a timeout.
+static inline uint8_t SPIWaitDone(void)
+{
+	uint16_t timeout = SPI_TIMEOUT;
+
+	while((SPSR & (1<<SPIF)) == 0)
+	{
+		if(--timeout == 0)
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+uint8_t SPITransfer(const uint8_t *tx, uint8_t *rx, uint16_t len)
+{
+	uint8_t out;
+	uint8_t in;
+
+	if(len == 0)
+	{
+		return SPI_STAT_OK;
+	}
+
+	out = (tx != NULL) ? *tx++ : 0xFF;
+	SPDR = out;
+
+	//The next byte is fetched while the current one shifts out, and the received byte is stored after the next one is started.
+	//SPDR is written right after SPIF is set, so the only gap between bytes is the SPIF poll and the SPDR read.
+	while(--len > 0)
+	{
+		out = (tx != NULL) ? *tx++ : 0xFF;
+		if(SPIWaitDone() == 0)
+		{
+			return SPI_STAT_TIMEOUT;
+		}
+		in = SPDR;
+		SPDR = out;
+		if(rx != NULL)
+		{
+			*rx++ = in;
+		}
+	}
+
+	if(SPIWaitDone() == 0)
+	{
+		return SPI_STAT_TIMEOUT;
+	}
+	in = SPDR;
+	if(rx != NULL)
+	{
+		*rx = in;
+	}
+	return SPI_STAT_OK;
+}
+
+uint8_t SPIWrite(const uint8_t *tx, uint16_t len)
+{
+	return SPITransfer(tx, NULL, len);
+}
+
+uint8_t SPIRead(uint8_t *rx, uint16_t len)
+{
+	return SPITransfer(NULL, rx, len);
+}
+
+#if SPI_USE_USART == 1
+void InitSPIUSARTMaster (uint8_t setup_cpol, uint8_t setup_cpha, uint8_t clock)
+{
+	if ((setup_cpol > 1) || (setup_cpha > 1) || (clock > SPI_CLOCK_MASK))
+	{
+		return;		//This is not allowed
+	}
+
+	//Turn on power to the USART
+	SPI_USART_PRR &= ~(1<<SPI_USART_PRR_BIT);
+
+	SPIUSARTSetup((1<<SPI_USART_BIT_UMSEL1)|(1<<SPI_USART_BIT_UMSEL0)|(setup_cpol<<SPI_USART_BIT_UCPOL)|(setup_cpha<<SPI_USART_BIT_UCPHA), SPIUSARTClockToUBRR(clock));
+	return;
+}
+
+//Baud rate is fosc/(2*(UBRR+1)), indexed by the SPI_CLOCK_DIVx setting
+static uint8_t SPIUSARTClockToUBRR(uint8_t clock)
+{
+	static const uint8_t ClockUBRR[8] = { 1, 7, 31, 63, 0, 3, 15, 31 };
+
+	return ClockUBRR[clock & SPI_CLOCK_MASK];
+}
+
+static void SPIUSARTSetup(uint8_t ucsrc, uint8_t ubrr)
+{
+	//The datasheet order: UBRR must be zero when the transmitter is enabled, then set the baud rate
+	SPI_UBRR = 0;
+	SPI_USART_XCK_DDR |= (1<<SPI_USART_XCK_BIT);
+	SPI_UCSRC = ucsrc;
+	SPI_UCSRB = (1<<SPI_USART_BIT_RXEN)|(1<<SPI_USART_BIT_TXEN);
+	SPI_UBRR = ubrr;
+}
+
+uint8_t SPIUSARTSendByte(uint8_t ByteToSend)
+{
+	uint8_t resp;
+
+	if(SPIUSARTTransfer(&ByteToSend, &resp, 1) != SPI_STAT_OK)
+	{
+		return 0xFF;
+	}
+	return resp;
+}
+
+uint8_t SPIUSARTTransfer(const uint8_t *tx, uint8_t *rx, uint16_t len)
+{
+	uint16_t sent = 0;
+	uint16_t received = 0;
+	uint16_t timeout = SPI_TIMEOUT;
+	uint8_t c;
+
+	//Throw away anything left in the receive buffer
+	while(SPI_UCSRA & (1<<SPI_USART_BIT_RXC))
+	{
+		c = SPI_UDR;
+	}
+
+	while(received < len)
+	{
+		//Keep the transmit buffer full, but never get more than two bytes ahead of the receiver so the receive buffer can not overflow
+		if((sent < len) && ((sent - received) < 2) && (SPI_UCSRA & (1<<SPI_USART_BIT_UDRE)))
+		{
+			SPI_UDR = (tx != NULL) ? tx[sent] : 0xFF;
+			sent++;
+		}
+
+		if(SPI_UCSRA & (1<<SPI_USART_BIT_RXC))
+		{
+			c = SPI_UDR;
+			if(rx != NULL)
+			{
+				rx[received] = c;
+			}
+			received++;
+			timeout = SPI_TIMEOUT;
+		}
+		else if(--timeout == 0)
+		{
+			return SPI_STAT_TIMEOUT;
+		}
+	}
+	return SPI_STAT_OK;
+}
+
+uint8_t SPIUSARTWrite(const uint8_t *tx, uint16_t len)
+{
+	return SPIUSARTTransfer(tx, NULL, len);
+}
+
+uint8_t SPIUSARTRead(uint8_t *rx, uint16_t len)
+{
+	return SPIUSARTTransfer(NULL, rx, len);
+}
+
+uint8_t SPIUSARTSelect(const SPIDevice *dev)
+{
+	uint8_t sreg = SREG;
+	uint8_t ucsrc;
+	uint8_t ubrr;
+
+	//Convert the SPI hardware settings of the device to the USART settings
+	ucsrc = (1<<SPI_USART_BIT_UMSEL1)|(1<<SPI_USART_BIT_UMSEL0);
+	if(dev->Spcr & (1<<CPOL))
+	{
+		ucsrc |= (1<<SPI_USART_BIT_UCPOL);
+	}
+	if(dev->Spcr & (1<<CPHA))
+	{
+		ucsrc |= (1<<SPI_USART_BIT_UCPHA);
+	}
+	if(dev->Spcr & (1<<DORD))
+	{
+		ucsrc |= (1<<SPI_USART_BIT_UDORD);
+	}
+	ubrr = SPIUSARTClockToUBRR((dev->Spcr & 0x03) | ((dev->Spsr & (1<<SPI2X)) ? 0x04 : 0x00));
+
+	cli();
+	if(SPI_USARTOwner != NULL)
+	{
+		SREG = sreg;
+		return SPI_STAT_BUSY;
+	}
+	SPI_USARTOwner = dev;
+
+	//Only change the settings if this device needs something different
+	if((SPI_UCSRC != ucsrc) || (SPI_UBRR != ubrr))
+	{
+		SPIUSARTSetup(ucsrc, ubrr);
+	}
+
+	*dev->CsPort &= ~dev->CsMask;
+	SREG = sreg;
+	return SPI_STAT_OK;
+}
+
+void SPIUSARTDeselect(const SPIDevice *dev)
+{
+	uint8_t sreg = SREG;
+
+	cli();
+	if(SPI_USARTOwner == dev)
+	{
+		*dev->CsPort |= dev->CsMask;
+		SPI_USARTOwner = NULL;
+	}
+	SREG = sreg;
+}
+#endif
+
+#if SPI_USE_ISR == 1
+uint8_t SPITransferStart(const uint8_t *tx, uint8_t *rx, uint16_t len, void (*done) (void))
+{
+	if(SPI_Busy)
+	{
+		return SPI_STAT_BUSY;
+	}
+
+	if(len == 0)
+	{
+		if(done != NULL)
+		{
+			done();
+		}
+		return SPI_STAT_OK;
+	}
+
+	SPI_TxData = tx;
+	SPI_RxData = rx;
+	SPI_BytesLeft = len - 1;
+	SPI_Done = done;
+	SPI_Busy = 1;
+
+	//Send the first byte, the ISR sends the rest
+	SPCR |= (1<<SPIE);
+	if(tx != NULL)
+	{
+		SPDR = *tx;
+		SPI_TxData = tx + 1;
+	}
+	else
+	{
+		SPDR = 0xFF;
+	}
+	return SPI_STAT_OK;
+}
+
+uint8_t SPIBusy(void)
+{
+	return SPI_Busy;
+}
+
+ISR(SPI_STC_vect)
+{
+	uint8_t c = SPDR;
+	const uint8_t *tx;
+	uint8_t *rx = SPI_RxData;
+
+	if(rx != NULL)
+	{
+		*rx = c;
+		SPI_RxData = rx + 1;
+	}
+
+	if(SPI_BytesLeft == 0)
+	{
+		SPCR &= ~(1<<SPIE);
+		SPI_Busy = 0;
+		if(SPI_Done != NULL)
+		{
+			SPI_Done();
+		}
+		return;
+	}
+	SPI_BytesLeft--;
+
+	tx = SPI_TxData;
+	if(tx != NULL)
+	{
+		SPDR = *tx;
+		SPI_TxData = tx + 1;
+	}
+	else
+	{
+		SPDR = 0xFF;
+	}
+}
+#endif
+
 
 /** @} */
@@ -31,19 +31,251 @@
 #define _SPI_H_
 
 #include "stdint.h"
+#include "config.h"
+
+/*These settings can be defined in your user code to change the SPI module
+ * #define SPI_USE_ISR				0		//Set to 1 to build the interrupt driven SPITransferStart() (uses the SPI_STC interrupt)
+ * #define SPI_USE_USART			0		//Set to 1 to build the second SPI bus on a USART in master SPI mode (the SPIUSART functions)
+ * #define SPI_USART_NUMBER			1		//The USART to use for the second SPI bus. Do not use this USART in UART.c.
+ */
+
+#ifndef SPI_USE_ISR
+	#define SPI_USE_ISR			0
+#endif
+
+#ifndef SPI_USE_USART
+	#define SPI_USE_USART		0
+#endif
+
+//The XCK pin of the USART is SCK for the second SPI bus. TXD is MOSI and RXD is MISO.
+#if SPI_USE_USART == 1
+	#if defined (__AVR_ATmega328P__) || defined (__AVR_ATmega328__)
+		#ifndef SPI_USART_NUMBER
+			#define SPI_USART_NUMBER	0
+		#endif
+		#if SPI_USART_NUMBER == 0
+			#define SPI_USART_XCK_DDR	DDRD
+			#define SPI_USART_XCK_BIT	4
+			#define SPI_USART_PRR		PRR
+			#define SPI_USART_PRR_BIT	PRUSART0
+		#endif
+	#elif defined (__AVR_ATmega32U4__)
+		#ifndef SPI_USART_NUMBER
+			#define SPI_USART_NUMBER	1
+		#endif
+		#if SPI_USART_NUMBER == 1
+			#define SPI_USART_XCK_DDR	DDRD
+			#define SPI_USART_XCK_BIT	5
+			#define SPI_USART_PRR		PRR1
+			#define SPI_USART_PRR_BIT	PRUSART1
+		#endif
+	#elif defined (__AVR_ATmega2561__)
+		#ifndef SPI_USART_NUMBER
+			#define SPI_USART_NUMBER	1
+		#endif
+		#if SPI_USART_NUMBER == 0
+			#define SPI_USART_XCK_DDR	DDRE
+			#define SPI_USART_XCK_BIT	2
+			#define SPI_USART_PRR		PRR0
+			#define SPI_USART_PRR_BIT	PRUSART0
+		#elif SPI_USART_NUMBER == 1
+			#define SPI_USART_XCK_DDR	DDRD
+			#define SPI_USART_XCK_BIT	5
+			#define SPI_USART_PRR		PRR1
+			#define SPI_USART_PRR_BIT	PRUSART1
+		#endif
+	#endif
+
+	#ifndef SPI_USART_XCK_DDR
+		#error: SPI_USART_NUMBER is not a USART with master SPI mode on this part
+	#endif
+#endif
 
 #define SPI_TIMEOUT		10000
 
+//Status codes for the multi-byte transfer functions
+#define SPI_STAT_OK				0x00
+#define SPI_STAT_TIMEOUT		0x01	//SPIF was not set in time, the SPI hardware is probably not set up
+#define SPI_STAT_BUSY			0x02	//An interrupt driven transfer is still running, or another device has the bus
+
+//SCK clock settings for InitSPIMasterClock() and SPISetClock()
+//Bits 0-1 are the SPR1:0 bits of SPCR, bit 2 is the SPI2X bit of SPSR
+#define SPI_CLOCK_DIV2			0x04
+#define SPI_CLOCK_DIV4			0x00
+#define SPI_CLOCK_DIV8			0x05
+#define SPI_CLOCK_DIV16			0x01
+#define SPI_CLOCK_DIV32			0x06
+#define SPI_CLOCK_DIV64			0x02
+#define SPI_CLOCK_DIV128		0x03
+#define SPI_CLOCK_MASK			0x07
+
+//SPI modes for SPIDeviceInit(), (CPOL << 1) | CPHA
+#define SPI_MODE0				0x00
+#define SPI_MODE1				0x01
+#define SPI_MODE2				0x02
+#define SPI_MODE3				0x03
+
+//Bit order for SPIDeviceInit()
+#define SPI_MSB_FIRST			0x00
+#define SPI_LSB_FIRST			0x01
+
+/** The settings of a device on the SPI bus. Fill this in with SPIDeviceInit(). */
+typedef struct SPIDevice
+{
+	/**The PORTx register of the chip select pin*/
+	volatile uint8_t *CsPort;
+
+	/**The chip select pin mask*/
+	uint8_t CsMask;
+
+	/**The SPCR value for this device (mode, bit order and clock)*/
+	uint8_t Spcr;
+
+	/**The SPSR value for this device (SPI2X)*/
+	uint8_t Spsr;
+} SPIDevice;
+
+/** Set up the SPI hardware as master with SCK at fosc/4
+*	\param[in] setup_cpol The clock polarity (0 or 1).
+*	\param[in] setup_cpha The clock phase (0 or 1).
+*/
 void InitSPIMaster (uint8_t setup_cpol, uint8_t setup_cpha);
 
+/** Set up the SPI hardware as master with a chosen SCK rate
+*	\param[in] setup_cpol The clock polarity (0 or 1).
+*	\param[in] setup_cpha The clock phase (0 or 1).
+*	\param[in] clock One of the SPI_CLOCK_DIVx settings.
+*/
+void InitSPIMasterClock (uint8_t setup_cpol, uint8_t setup_cpha, uint8_t clock);
+
+/** Change the SCK rate without changing the mode or bit order. Do not call this during a transfer.
+*	\param[in] clock One of the SPI_CLOCK_DIVx settings.
+*/
+void SPISetClock(uint8_t clock);
+
+/** Returns the current SCK rate as one of the SPI_CLOCK_DIVx settings */
+uint8_t SPIGetClock(void);
+
+/** Find the fastest SCK setting that does not go over a frequency. For example, SD cards must be started at 400kHz or less.
+*	\param[in] MaxFreqHz The highest allowed SCK frequency in Hz.
+*
+*	\return One of the SPI_CLOCK_DIVx settings. SPI_CLOCK_DIV128 is returned if even that is too fast.
+*/
+uint8_t SPIClockForFreq(uint32_t MaxFreqHz);
+
 uint8_t SPISendByte(int8_t ByteToSend);
 
+/** Send and receive a block of bytes.
+*	\param[in] *tx The bytes to send, or NULL to send 0xFF.
+*	\param[out] *rx Where to put the received bytes, or NULL to throw them away.
+*	\param[in] len The number of bytes to transfer.
+*
+*	\return SPI_STAT_OK, or SPI_STAT_TIMEOUT if a byte did not finish. Unlike SPISendByte(), a timeout cannot be mistaken for data.
+*/
+uint8_t SPITransfer(const uint8_t *tx, uint8_t *rx, uint16_t len);
 
+/** Send a block of bytes and ignore the received data.
+*	\param[in] *tx The bytes to send.
+*	\param[in] len The number of bytes to send.
+*
+*	\return SPI_STAT_OK or SPI_STAT_TIMEOUT
+*/
+uint8_t SPIWrite(const uint8_t *tx, uint16_t len);
 
+/** Receive a block of bytes while sending 0xFF.
+*	\param[out] *rx Where to put the received bytes.
+*	\param[in] len The number of bytes to receive.
+*
+*	\return SPI_STAT_OK or SPI_STAT_TIMEOUT
+*/
+uint8_t SPIRead(uint8_t *rx, uint16_t len);
+
+/** Set up a device on the SPI bus. The chip select pin is made an output and driven high (not selected).
+*	\param[out] dev The device to set up.
+*	\param[in] CsPort The PORTx register of the chip select pin (for example &PORTB).
+*	\param[in] CsPin The pin number of the chip select pin.
+*	\param[in] mode One of the SPI_MODEx settings.
+*	\param[in] clock One of the SPI_CLOCK_DIVx settings.
+*	\param[in] BitOrder SPI_MSB_FIRST or SPI_LSB_FIRST.
+*/
+void SPIDeviceInit(SPIDevice *dev, volatile uint8_t *CsPort, uint8_t CsPin, uint8_t mode, uint8_t clock, uint8_t BitOrder);
+
+/** Take the bus for a device and pull its chip select low. SPCR and SPSR are only written if the device settings are different from the current ones.
+*	InitSPIMaster() must have been called once before this. This does not wait, so it can be used from an ISR.
+*	\param[in] dev The device to select.
+*
+*	\return SPI_STAT_OK, or SPI_STAT_BUSY if another device has the bus
+*/
+uint8_t SPISelect(const SPIDevice *dev);
+
+/** Release chip select and give up the bus. Does nothing if the device does not have the bus.
+*	\param[in] dev The device to deselect.
+*/
+void SPIDeselect(const SPIDevice *dev);
+
+#if SPI_USE_USART == 1
+/** Set up the USART as a second SPI master. The USART clock is fosc/2 at most.
+*	\param[in] setup_cpol The clock polarity (0 or 1).
+*	\param[in] setup_cpha The clock phase (0 or 1).
+*	\param[in] clock One of the SPI_CLOCK_DIVx settings, the same rates as the SPI hardware.
+*/
+void InitSPIUSARTMaster (uint8_t setup_cpol, uint8_t setup_cpha, uint8_t clock);
+
+/** Send and receive a single byte on the USART SPI bus.
+*	\param[in] ByteToSend The byte to send.
+*
+*	\return The received byte, or 0xFF on a timeout
+*/
+uint8_t SPIUSARTSendByte(uint8_t ByteToSend);
 
+/** Send and receive a block of bytes on the USART SPI bus. The USART transmitter is double buffered, so bytes go out back to back.
+*	\param[in] *tx The bytes to send, or NULL to send 0xFF.
+*	\param[out] *rx Where to put the received bytes, or NULL to throw them away.
+*	\param[in] len The number of bytes to transfer.
+*
+*	\return SPI_STAT_OK or SPI_STAT_TIMEOUT
+*/
+uint8_t SPIUSARTTransfer(const uint8_t *tx, uint8_t *rx, uint16_t len);
+
+/** Send a block of bytes on the USART SPI bus and ignore the received bytes.
+*	\return SPI_STAT_OK or SPI_STAT_TIMEOUT
+*/
+uint8_t SPIUSARTWrite(const uint8_t *tx, uint16_t len);
+
+/** Read a block of bytes from the USART SPI bus while sending 0xFF.
+*	\return SPI_STAT_OK or SPI_STAT_TIMEOUT
+*/
+uint8_t SPIUSARTRead(uint8_t *rx, uint16_t len);
+
+/** Take the USART SPI bus for a device and pull its chip select low. This works like SPISelect(), but the bus has its own lock.
+*	The mode, bit order and clock of the device are converted to the USART settings.
+*	\param[in] dev The device to select.
+*
+*	\return SPI_STAT_OK, or SPI_STAT_BUSY if another device has the bus
+*/
+uint8_t SPIUSARTSelect(const SPIDevice *dev);
 
+/** Release chip select and give up the USART SPI bus.
+*	\param[in] dev The device to deselect.
+*/
+void SPIUSARTDeselect(const SPIDevice *dev);
+#endif
 
+#if SPI_USE_ISR == 1
+/** Start an interrupt driven transfer and return right away. Global interrupts must be on.
+*	The buffers must stay valid until the transfer is done. Do not call the other SPI functions while it is running.
+*	\param[in] *tx The bytes to send, or NULL to send 0xFF.
+*	\param[out] *rx Where to put the received bytes, or NULL to throw them away.
+*	\param[in] len The number of bytes to transfer.
+*	\param[in] done Called from the SPI ISR when the transfer is finished, or NULL.
+*
+*	\return SPI_STAT_OK if the transfer was started, SPI_STAT_BUSY if one is already running
+*/
+uint8_t SPITransferStart(const uint8_t *tx, uint8_t *rx, uint16_t len, void (*done) (void));
 
+/** Returns 1 while an interrupt driven transfer is running */
+uint8_t SPIBusy(void);
+#endif
 
 #endif
 
@@ -0,0 +1,177 @@
+/*   This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+*	\brief		SLIP framing with CRC-16 for the UART driver
+*	\author		Pat Satyshur
+*	\version	1.0
+*	\date		3/9/2013
+*	\copyright	Copyright 2013, Pat Satyshur
+*	\ingroup 	interface
+*
+*	The receiver runs in the RX ISR of the port. A SLIP_END byte always ends the current frame, so after line noise the receiver is back in sync at the next frame.
+*
+*	@{
+*/
+
+#include <avr/io.h>
+#include <util/crc16.h>
+#include "uart_frame.h"
+
+/** Size of the stack buffer used to send a frame in blocks with UARTWrite() */
+#define UART_FRAME_CHUNK_SIZE		16
+
+static void UARTFrame_RxByte(void *HandlerData, uint8_t c);
+static void UARTFrame_ResetRx(UARTFrameRx *rx);
+
+void UARTFrame_InitRx(const UARTPort *port, UARTFrameRx *rx, uint8_t *buffer, uint8_t size, void (*FrameComplete) (uint8_t *data, uint8_t len))
+{
+	rx->Buffer = buffer;
+	rx->Size = size;
+	rx->ErrorCount = 0;
+	rx->FrameComplete = FrameComplete;
+	UARTFrame_ResetRx(rx);
+
+	UARTSetRxHandler(port, UARTFrame_RxByte, rx);
+}
+
+void UARTFrame_StopRx(const UARTPort *port)
+{
+	UARTSetRxHandler(port, NULL, NULL);
+}
+
+uint16_t UARTFrame_Send(const UARTPort *port, const uint8_t *data, uint8_t len)
+{
+	uint8_t chunk[UART_FRAME_CHUNK_SIZE];
+	uint8_t n = 0;
+	uint16_t sent = 0;
+	uint16_t crc = 0xFFFF;
+	uint16_t i;
+	uint8_t c;
+
+	chunk[n++] = SLIP_END;
+
+	//Send the data followed by the two CRC bytes, low byte first
+	for(i = 0; i < (uint16_t)len + 2; i++)
+	{
+		if(i < len)
+		{
+			c = data[i];
+			crc = _crc_ccitt_update(crc, c);
+		}
+		else if(i == len)
+		{
+			c = crc & 0xFF;
+		}
+		else
+		{
+			c = crc >> 8;
+		}
+
+		if(c == SLIP_END)
+		{
+			chunk[n++] = SLIP_ESC;
+			chunk[n++] = SLIP_ESC_END;
+		}
+		else if(c == SLIP_ESC)
+		{
+			chunk[n++] = SLIP_ESC;
+			chunk[n++] = SLIP_ESC_ESC;
+		}
+		else
+		{
+			chunk[n++] = c;
+		}
+
+		//Keep room for an escaped byte
+		if(n >= UART_FRAME_CHUNK_SIZE - 2)
+		{
+			sent += UARTWrite(port, chunk, n);
+			n = 0;
+		}
+	}
+
+	chunk[n++] = SLIP_END;
+	sent += UARTWrite(port, chunk, n);
+	return sent;
+}
+
+static void UARTFrame_ResetRx(UARTFrameRx *rx)
+{
+	rx->Length = 0;
+	rx->Escaped = 0;
+	rx->Discard = 0;
+	rx->crc = 0xFFFF;
+}
+
+//Called from the RX ISR for each received byte
+static void UARTFrame_RxByte(void *HandlerData, uint8_t c)
+{
+	UARTFrameRx *rx = (UARTFrameRx *)HandlerData;
+
+	if(c == SLIP_END)
+	{
+		//Running the CRC over the data and the received CRC leaves 0 if the frame is good
+		if((rx->Discard == 0) && (rx->Escaped == 0) && (rx->Length >= 2) && (rx->crc == 0))
+		{
+			rx->FrameComplete(rx->Buffer, rx->Length - 2);
+		}
+		else if(((rx->Length > 0) || (rx->Discard != 0)) && (rx->ErrorCount < 0xFF))
+		{
+			//Back to back SLIP_END bytes are allowed and are not an error
+			rx->ErrorCount++;
+		}
+		UARTFrame_ResetRx(rx);
+		return;
+	}
+
+	if(rx->Discard != 0)
+	{
+		return;
+	}
+
+	if(rx->Escaped != 0)
+	{
+		rx->Escaped = 0;
+		if(c == SLIP_ESC_END)
+		{
+			c = SLIP_END;
+		}
+		else if(c == SLIP_ESC_ESC)
+		{
+			c = SLIP_ESC;
+		}
+		else
+		{
+			rx->Discard = 1;	//Bad escape sequence
+			return;
+		}
+	}
+	else if(c == SLIP_ESC)
+	{
+		rx->Escaped = 1;
+		return;
+	}
+
+	if(rx->Length >= rx->Size)
+	{
+		rx->Discard = 1;		//Frame is too long
+		return;
+	}
+
+	rx->Buffer[rx->Length++] = c;
+	rx->crc = _crc_ccitt_update(rx->crc, c);
+}
+
+/** @} */
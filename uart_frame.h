@@ -0,0 +1,99 @@
+/*   This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file
+*	\brief		SLIP framing with CRC-16 for the UART driver header
+*	\author		Pat Satyshur
+*	\version	1.0
+*	\date		3/9/2013
+*	\copyright	Copyright 2013, Pat Satyshur
+*	\ingroup 	interface
+*
+*	Frames are SLIP encoded (RFC 1055) with a CRC-16-CCITT appended before the closing END byte.
+*	The CRC uses _crc_ccitt_update() from avr-libc, starts at 0xFFFF and is sent low byte first.
+*	Frames are decoded in the UART RX ISR, so UART_USE_BUFFERS and UART_USE_RX_HANDLER must be set to 1.
+*
+*	@{
+*/
+
+#ifndef _UART_FRAME_H_
+#define _UART_FRAME_H_
+
+#include "stdint.h"
+#include "UART.h"
+
+#if (UART_USE_BUFFERS != 1) || (UART_USE_RX_HANDLER != 1)
+	#error: UART framing needs UART_USE_BUFFERS and UART_USE_RX_HANDLER set to 1
+#endif
+
+//SLIP special characters
+#define SLIP_END					0xC0
+#define SLIP_ESC					0xDB
+#define SLIP_ESC_END				0xDC
+#define SLIP_ESC_ESC				0xDD
+
+/** The state of a frame receiver. One of these is needed for each port that receives frames. */
+typedef struct UARTFrameRx
+{
+	/**Where the frame being received is stored*/
+	uint8_t *Buffer;
+
+	/**Size of Buffer, this must include room for the two CRC bytes*/
+	uint8_t Size;
+
+	/**Number of bytes received in this frame so far*/
+	uint8_t Length;
+
+	/**Set after a SLIP_ESC byte*/
+	uint8_t Escaped;
+
+	/**Set when the frame is bad (too long or bad escape). The rest of the frame is ignored until the next SLIP_END.*/
+	uint8_t Discard;
+
+	/**Running CRC of the frame*/
+	uint16_t crc;
+
+	/**Number of frames dropped because of a bad CRC, bad escape or overflow*/
+	uint8_t ErrorCount;
+
+	/**Called from the RX ISR with each good frame (without the CRC). The data is only valid until the function returns.*/
+	void (*FrameComplete) (uint8_t *data, uint8_t len);
+} UARTFrameRx;
+
+/** Start receiving frames on a port. Received bytes no longer go to the RX buffer of the port.
+*	\param[in] port The port to receive on.
+*	\param[in] rx The receiver state to use.
+*	\param[in] *buffer The buffer for a received frame.
+*	\param[in] size The size of the buffer. Two bytes are used for the CRC.
+*	\param[in] FrameComplete Called from the RX ISR with each good frame.
+*/
+void UARTFrame_InitRx(const UARTPort *port, UARTFrameRx *rx, uint8_t *buffer, uint8_t size, void (*FrameComplete) (uint8_t *data, uint8_t len));
+
+/** Stop receiving frames on a port, received bytes go to the RX buffer again.
+*	\param[in] port The port.
+*/
+void UARTFrame_StopRx(const UARTPort *port);
+
+/** Send one frame.
+*	\param[in] port The port to send on.
+*	\param[in] *data The frame data.
+*	\param[in] len The number of bytes in the frame.
+*
+*	\return The number of bytes queued, including escapes, CRC and SLIP_END bytes
+*/
+uint16_t UARTFrame_Send(const UARTPort *port, const uint8_t *data, uint8_t len);
+
+#endif
+
+/** @} */